@@ -0,0 +1,83 @@
+#include "Batch.hpp"
+#include "Workspace.hpp"
+#include <stdexcept>
+#include <thread>
+#include <opencv2/imgcodecs.hpp>
+
+bool Batch::WorkQueue::pop(int &page) {
+    lock_guard<mutex> guard(this->lock);
+    if (this->pages.empty()) return false;
+    page = this->pages.front();
+    this->pages.pop_front();
+    return true;
+}
+
+bool Batch::WorkQueue::steal(int &page) {
+    lock_guard<mutex> guard(this->lock);
+    if (this->pages.empty()) return false;
+    page = this->pages.back();
+    this->pages.pop_back();
+    return true;
+}
+
+void Batch::WorkQueue::push(int page) {
+    lock_guard<mutex> guard(this->lock);
+    this->pages.push_back(page);
+}
+
+Batch::Batch(const Pipeline &pipeline, int threads): threads(threads), pipeline(pipeline) {}
+
+// no pages are added once the threads run, so a thread is done when all queues are empty
+void Batch::work(int self, vector<WorkQueue> &queues, const vector<Mat> &images, const vector<string> &paths, vector<PageResult> &results, vector<string> &errors) {
+    Pipeline local = this->pipeline;
+    int n = (int) queues.size();
+    int page;
+    while (true) {
+        bool found = queues[self].pop(page);
+        for (int k=1; !found && k<n; k++)
+            found = queues[(self + k) % n].steal(page);
+        if (!found) break;
+
+        try {
+            Mat image = images[page];
+            if (image.empty()) {
+                image = imread(paths[page], IMREAD_ANYCOLOR);
+                if (image.empty())
+                    throw runtime_error("Failed to read file " + paths[page]);
+            }
+            local.process(image, results[page]);
+        } catch (const exception &e) {
+            errors[page] = e.what();
+        } catch (...) {
+            errors[page] = "Unknown error";
+        }
+    }
+    // the calling thread outlives the batch, do not keep the scratch images of its pages
+    Workspace::local().release();
+}
+
+void Batch::process(const vector<Mat> &images, const vector<string> &paths, vector<PageResult> &results, vector<string> &errors) {
+    int pages = (int) max(images.size(), paths.size());
+    results.assign(pages, PageResult());
+    errors.assign(pages, string());
+
+    int n = this->threads > 0 ? this->threads : (int) thread::hardware_concurrency();
+    n = max(1, min(n, pages));
+
+    // consecutive pages per thread, the stealing balances out the differences in size
+    vector<WorkQueue> queues(n);
+    for (int i=0; i<pages; i++)
+        queues[(int) ((long long) i * n / max(pages, 1))].push(i);
+
+    vector<Mat> pageImages = images;
+    vector<string> pagePaths = paths;
+    pageImages.resize(pages);
+    pagePaths.resize(pages);
+    // the calling thread is one of the workers
+    vector<thread> workers;
+    for (int t=1; t<n; t++)
+        workers.push_back(thread(&Batch::work, this, t, ref(queues), cref(pageImages), cref(pagePaths), ref(results), ref(errors)));
+    work(0, queues, pageImages, pagePaths, results, errors);
+    for (auto &worker : workers)
+        worker.join();
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Pipeline.hpp"
+
+using namespace cv;
+using namespace std;
+
+// Runs the pipeline over many pages on a pool of threads. Each thread takes the pages of its own
+// queue from the front and, once it is empty, steals pages from the back of the queues of the other
+// threads, so a few large pages do not leave the other threads idle. The results are in page order.
+class Batch {
+    public:
+        // threads <= 0 uses the number of cores
+        Batch(const Pipeline &pipeline, int threads = 0);
+
+        // page i is images[i] or, if that is empty, the image file paths[i]. errors[i] is the
+        // message of the exception thrown by page i, empty if it succeeded
+        void process(const vector<Mat> &images, const vector<string> &paths, vector<PageResult> &results, vector<string> &errors);
+
+        int threads;
+
+    private:
+        class WorkQueue {
+            public:
+                bool pop(int &page);
+                bool steal(int &page);
+                void push(int page);
+
+            private:
+                mutex lock;
+                deque<int> pages;
+        };
+
+        Pipeline pipeline;
+
+        void work(int self, vector<WorkQueue> &queues, const vector<Mat> &images, const vector<string> &paths, vector<PageResult> &results, vector<string> &errors);
+};
@@ -1,258 +1,395 @@
 #include "Binarization.hpp"
+#include "Workspace.hpp"
+#include <climits>
+#include <mutex>
+#include <opencv2/core/utility.hpp>
 
 #define uget(x,y)at<unsigned char>(y,x)
 #define uset(x,y,v)at<unsigned char>(y,x)=v;
 #define fget(x,y)at<float>(y,x)
 #define fset(x,y,v)at<float>(y,x)=v;
 
-Binarization::Binarization() {}
+Binarization::Binarization() {
+    this->introspection = false;
+    this->tileRows = 0;
+}
 
-void Binarization::binarize(Mat image, Mat &output, bool light, int option){
+void Binarization::binarize(Mat image, Mat &output, bool light, int option, double lightScale){
 	Mat grayscale;
-	cvtColor(image, grayscale, COLOR_BGR2GRAY);
+	if (image.channels() == 1){
+	    // grayscale input is used as is, already binary input is passed through
+	    Mat nonBinary;
+	    inRange(image, Scalar(1), Scalar(254), nonBinary);
+	    if (countNonZero(nonBinary) == 0){
+	        output = image;
+	        return;
+	    }
+	    grayscale = image;
+	} else if (image.channels() == 4){
+	    cvtColor(image, grayscale, COLOR_BGRA2GRAY);
+	} else {
+	    cvtColor(image, grayscale, COLOR_BGR2GRAY);
+	}
 
 	if (light){
-	    lightDistribution(grayscale);
+	    lightDistribution(grayscale, lightScale);
 	} 
 
     int winy = (int) (2.0 * grayscale.rows-1)/3;
     int winx = (int) grayscale.cols-1 < winy ? grayscale.cols-1 : winy;
     if (winx > 127) winx = winy = 127;
+    if (winx < 1) winx = 1;
+    if (winy < 1) winy = 1;
 
-    thresholdImg(grayscale, output, option, winx, winy, 0.1, 128);
+    double k = option == BINARIZE_BRADLEY ? 0.15 : 0.1;
+    thresholdImg(grayscale, output, option, winx, winy, k, 128);
 }
 
-void Binarization::thresholdImg(Mat im, Mat &output, int option, int winx, int winy, double k, double dR){
+// Local mean and standard deviation of the winx x winy windows from the
+// integral images, the window of the output row j starts at integral row j.
+// S is int when the sums fit in 32 bits, the sums of squares are exact in a double.
+template<typename S>
+class LocalStats {
+	public:
+		LocalStats(const Mat &imSum, const Mat &imSumSq, int winx, int winy)
+			: imSum(imSum), imSumSq(imSumSq), winx(winx), winy(winy), winarea(winx*winy) {}
+
+		// n = cols-winx+1 windows of rows j .. j+winy-1, only the means
+		void meanRow(int j, int n, float *mapM) const {
+			const S *sumTop = imSum.ptr<S>(j);
+			const S *sumBottom = imSum.ptr<S>(j + winy);
+
+			for (int i=0; i<n; i++){
+				double sum = (double) ((sumBottom[i+winx] - sumBottom[i]) - (sumTop[i+winx] - sumTop[i]));
+				mapM[i] = sum / winarea;
+			}
+		}
 
-	if (option > 1){
-		double m, s, maxS;
-		double th = 0;
-		double minI, maxI;
-		int wxh	= winx/2;
-		int wyh	= winy/2;
-		int xFirstth= wxh;
-		int xLastth = im.cols-wxh-1;
-		int yLastth = im.rows-wyh-1;
-		int yFirstth = wyh;
-
-		output = im.clone();
-		Mat mapM = Mat::zeros(im.rows, im.cols, CV_32F);
-		Mat mapS = Mat::zeros(im.rows, im.cols, CV_32F);
-		maxS = calcLocalStats(im, mapM, mapS, winx, winy);
-
-		minMaxLoc(im, &minI, &maxI);
-		Mat thsurf(im.rows, im.cols, CV_32F);
-
-		for	(int j=yFirstth; j<=yLastth; j++){
-			float *thSurfData = thsurf.ptr<float>(j) + wxh;
-			float *mapMData = mapM.ptr<float>(j) + wxh;
-			float *mapSData = mapS.ptr<float>(j) + wxh;
-
-			for	(int i=0; i<=im.cols-winx; i++) {
-				m = *mapMData++;
-				s = *mapSData++;
-
-				switch (option) {
-					case 2: // NIBLACK
-						th = m + k*s;
-						break;
-
-					case 3: // SAUVOLA
-						th = m * (1 + k*(s/dR-1));
-						break;
-
-					case 4: // WOLF
-						th = m + k * (s/maxS-1) * (m-minI);
-						break;
-				}
-				*thSurfData++ = th;
-
-				if (i==0){
-					float *thSurfPtr = thsurf.ptr<float>(j);
-					for (int i=0; i<=xFirstth; ++i)
-						*thSurfPtr++ = th;
-
-					if (j==yFirstth){
-						for (int u=0; u<yFirstth; ++u){
-							float *thSurfPtr = thsurf.ptr<float>(u);
-							for (int i=0; i<=xFirstth; ++i)
-								*thSurfPtr++ = th;
-						}
-					}
-
-					if (j == yLastth){
-						for (int u=yLastth+1; u<im.rows; ++u){
-							float *thSurfPtr = thsurf.ptr<float>(u);
-
-							for (int i=0; i<=xFirstth; ++i)
-								*thSurfPtr++ = th;
-						}
-					}
-				}
+		// n = cols-winx+1 windows of rows j .. j+winy-1, returns the max deviation
+		double row(int j, int n, float *mapM, float *mapS) const {
+			const S *sumTop = imSum.ptr<S>(j);
+			const S *sumBottom = imSum.ptr<S>(j + winy);
+			const double *sumSqTop = imSumSq.ptr<double>(j);
+			const double *sumSqBottom = imSumSq.ptr<double>(j + winy);
+			double maxS = 0;
+
+			for (int i=0; i<n; i++){
+				double sum = (double) ((sumBottom[i+winx] - sumBottom[i]) - (sumTop[i+winx] - sumTop[i]));
+				double sumSq = (sumSqBottom[i+winx] + sumSqTop[i]) - (sumSqTop[i+winx] + sumSqBottom[i]);
+				double m = sum / winarea;
+				double s = sqrt((sumSq - m*sum)/winarea);
+				mapM[i] = m;
+				mapS[i] = s;
+				maxS = s > maxS ? s : maxS;
+			}
+			return maxS;
+		}
 
-				if (j==yFirstth)
-					for (int u=0; u<yFirstth; ++u)
-						thsurf.fset(i+wxh,u,th);
+	private:
+		const Mat &imSum, &imSumSq;
+		const int winx, winy;
+		const double winarea;
+};
 
-				if (j==yLastth)
-					for (int u=yLastth+1; u<im.rows; ++u)
-						thsurf.fset(i+wxh,u,th);
-			}
-			float *thSurfPtr = thsurf.ptr<float>(j) + xLastth;
+struct ThresholdParams {
+	int winx, winy;
+	double k, dR, maxS, minI;
+};
 
-			for (int i=xLastth; i<im.cols; ++i)
-				*thSurfPtr++ = th;
+template<int Method> inline double localThreshold(double m, double s, const ThresholdParams &p);
 
-			if (j==yFirstth){
-				for (int u=0; u<yFirstth; ++u){
-					float *thSurfPtr = thsurf.ptr<float>(u) + xLastth;
+template<> inline double localThreshold<BINARIZE_NIBLACK>(double m, double s, const ThresholdParams &p){
+	return m + p.k*s;
+}
 
-					for (int i=xLastth; i<im.cols; ++i)
-						*thSurfPtr++ = th;
-				}
-			}
+template<> inline double localThreshold<BINARIZE_SAUVOLA>(double m, double s, const ThresholdParams &p){
+	return m * (1 + p.k*(s/p.dR-1));
+}
 
-			if (j==yLastth){
-				for (int u=yLastth+1; u<im.rows; ++u){
-					float *thSurfPtr = thsurf.ptr<float>(u) + xLastth;
+template<> inline double localThreshold<BINARIZE_WOLF>(double m, double s, const ThresholdParams &p){
+	return m + p.k * (s/p.maxS-1) * (m-p.minI);
+}
 
-					for (int i=xLastth; i<im.cols; ++i)
-						*thSurfPtr++ = th;
-				}
-			}
-		}
+// Bradley-Roth: below the local mean by more than a fraction k
+template<> inline double localThreshold<BINARIZE_BRADLEY>(double m, double, const ThresholdParams &p){
+	return m * (1 - p.k);
+}
 
-		for	(int y=0; y<im.rows; ++y){
-			unsigned char *imData = im.ptr<unsigned char>(y);
-			float *thSurfData = thsurf.ptr<float>(y);
-			unsigned char *outputData = output.ptr<unsigned char>(y);
+// Thresholds a band of rows, the integral images start at image row
+// statsOffset. The thresholds of the rows and cols closer than
+// half a window to the border are those of the nearest full window, the right
+// border starting at col cols-winx/2-1 as in the original threshold surface.
+template<int Method, typename S>
+class ThresholdBody : public ParallelLoopBody {
+	public:
+		ThresholdBody(const Mat &im, Mat &output, const LocalStats<S> &stats, const ThresholdParams &p, int statsOffset)
+			: im(im), output(output), stats(stats), p(p), statsOffset(statsOffset) {}
+
+		void operator()(const Range &range) const {
+			int wxh = p.winx/2;
+			int wyh = p.winy/2;
+			int n = im.cols-p.winx+1;
+			int xLastth = im.cols-wxh-1;
+			int yFirstth = wyh;
+			int yLastth = im.rows-wyh-1;
+
+			vector<float> mapM(n), mapS(n), thsurf(im.cols);
+			int statsRow = -1;
+
+			for (int j=range.start; j<range.end; j++){
+				int jc = min(max(j, yFirstth), yLastth);
+				if (jc != statsRow){
+					if (Method == BINARIZE_BRADLEY)
+						stats.meanRow(jc-wyh-statsOffset, n, mapM.data());
+					else
+						stats.row(jc-wyh-statsOffset, n, mapM.data(), mapS.data());
+					for (int i=0; i<n; i++)
+						thsurf[i+wxh] = localThreshold<Method>(mapM[i], mapS[i], p);
+
+					float thFirst = thsurf[wxh];
+					float thLast = thsurf[n-1+wxh];
+					fill(thsurf.begin(), thsurf.begin()+wxh, thFirst);
+					fill(thsurf.begin()+xLastth, thsurf.end(), thLast);
+					statsRow = jc;
+				}
 
-			for	(int x=0; x<im.cols; ++x){
-				*outputData = *imData >= *thSurfData ? 255 : 0;
-				imData++;
-				thSurfData++;
-				outputData++;
+				const unsigned char *imData = im.ptr<unsigned char>(j);
+				unsigned char *outputData = output.ptr<unsigned char>(j);
+				const float *thSurfData = thsurf.data();
+				for (int x=0; x<im.cols; x++)
+					outputData[x] = imData[x] >= thSurfData[x] ? 255 : 0;
 			}
 		}
 
-	} else if (option == 1){
-		Mat smoothedImg;
-		blur(im, smoothedImg, Size(3,3), Point(-1,-1));
-		threshold(smoothedImg, output, 0.0, 255, THRESH_BINARY | THRESH_OTSU);
+	private:
+		const Mat &im;
+		Mat &output;
+		const LocalStats<S> &stats;
+		const ThresholdParams &p;
+		const int statsOffset;
+};
+
+// Max deviation over all windows, needed upfront by Wolf
+template<typename S>
+class MaxDeviationBody : public ParallelLoopBody {
+	public:
+		MaxDeviationBody(int cols, const LocalStats<S> &stats, const ThresholdParams &p, double &maxS, std::mutex &lock)
+			: cols(cols), stats(stats), p(p), maxS(maxS), lock(lock) {}
+
+		void operator()(const Range &range) const {
+			int n = cols-p.winx+1;
+			vector<float> mapM(n), mapS(n);
+			double bandMax = 0;
+			for (int j=range.start; j<range.end; j++)
+				bandMax = max(bandMax, stats.row(j, n, mapM.data(), mapS.data()));
+
+			std::lock_guard<std::mutex> guard(lock);
+			if (bandMax > maxS) maxS = bandMax;
+		}
 
-	} else {
-		threshold(im, output, 127, 255, THRESH_BINARY);
+	private:
+		const int cols;
+		const LocalStats<S> &stats;
+		const ThresholdParams &p;
+		double &maxS;
+		std::mutex &lock;
+};
+
+// Thresholds the rows r0 .. r1-1 with the integral images of the image rows
+// starting at statsOffset, or only updates p.maxS if maxOnly
+template<typename S>
+static void thresholdBand(const Mat &im, Mat &output, int option, ThresholdParams &p, int r0, int r1, int statsOffset, const Mat &imSum, const Mat &imSumSq, bool maxOnly){
+	LocalStats<S> stats(imSum, imSumSq, p.winx, p.winy);
+	Range rows(r0, r1);
+
+	if (maxOnly){
+		int wyh = p.winy/2;
+		int first = max(r0, wyh);
+		int last = min(r1-1, im.rows-wyh-1);
+		std::mutex lock;
+		if (first <= last)
+			parallel_for_(Range(first-wyh-statsOffset, last-wyh-statsOffset+1), MaxDeviationBody<S>(im.cols, stats, p, p.maxS, lock));
+		return;
 	}
-}
 
-double Binarization::calcLocalStats(Mat &im, Mat &mapM, Mat &mapS, int winx, int winy){
-    Mat imSum, imSumSq;
-    integral(im, imSum, imSumSq, CV_64F);
+	switch (option) {
+		case BINARIZE_NIBLACK:
+			parallel_for_(rows, ThresholdBody<BINARIZE_NIBLACK, S>(im, output, stats, p, statsOffset));
+			break;
 
-	double m,s,maxS,sum,sumSq;
-	int wxh	= winx/2;
-	int wyh	= winy/2;
-	int xFirstth= wxh;
-    int yFirstth= wyh;
-	int yLastth = im.rows-wyh-1;
-	double winarea = winx*winy;
-
-	maxS = 0;
-	for	(int j = yFirstth ; j<=yLastth; j++){
-		sum = sumSq = 0;
+		case BINARIZE_SAUVOLA:
+			parallel_for_(rows, ThresholdBody<BINARIZE_SAUVOLA, S>(im, output, stats, p, statsOffset));
+			break;
 
-		double *sumTopLeft = imSum.ptr<double>(j - wyh);
-		double *sumTopRight = sumTopLeft + winx;
-		double *sumBottomLeft = imSum.ptr<double>(j - wyh + winy);
-		double *sumBottomRight = sumBottomLeft + winx;
+		case BINARIZE_WOLF:
+			parallel_for_(rows, ThresholdBody<BINARIZE_WOLF, S>(im, output, stats, p, statsOffset));
+			break;
 
-		double *sumEqTopLeft = imSumSq.ptr<double>(j - wyh);
-		double *sumEqTopRight = sumEqTopLeft + winx;
-		double *sumEqBottomLeft = imSumSq.ptr<double>(j - wyh + winy);
-		double *sumEqBottomRight = sumEqBottomLeft + winx;
+		case BINARIZE_BRADLEY:
+			parallel_for_(rows, ThresholdBody<BINARIZE_BRADLEY, S>(im, output, stats, p, statsOffset));
+			break;
+	}
+}
 
-		sum = (*sumBottomRight + *sumTopLeft) - (*sumTopRight + *sumBottomLeft);
-		sumSq = (*sumEqBottomRight + *sumEqTopLeft) - (*sumEqTopRight + *sumEqBottomLeft);
+// Integral images of the image rows needed for the output rows r0 .. r1-1,
+// these are the rows within half a window, clamped to the full windows
+static void localBand(const Mat &im, Mat &output, int option, ThresholdParams &p, int r0, int r1, bool maxOnly){
+	int wyh = p.winy/2;
+	int yFirstth = wyh;
+	int yLastth = im.rows-wyh-1;
+	int a = min(max(r0, yFirstth), yLastth) - wyh;
+	int b = min(max(r1-1, yFirstth), yLastth) - wyh + p.winy;
+
+	// the sums fit in 32-bit integers unless the band is huge, the sums of
+	// squares stay exact integers in a double
+	Mat band = im.rowRange(a, b);
+	bool exact32 = 255.0 * (band.rows+1) * (band.cols+1) <= INT_MAX;
+	int sdepth = exact32 ? CV_32S : CV_64F;
+
+	Workspace &workspace = Workspace::local();
+	Mat imSum = workspace.get("binarization.sum", band.rows+1, band.cols+1, sdepth);
+	Mat imSumSq;
+	if (option == BINARIZE_BRADLEY){
+		integral(band, imSum, sdepth);
+	} else {
+		imSumSq = workspace.get("binarization.sumsq", band.rows+1, band.cols+1, CV_64F);
+		integral(band, imSum, imSumSq, sdepth, CV_64F);
+	}
 
-		m  = sum / winarea;
-		s  = sqrt ((sumSq - m*sum)/winarea);
-		if (s > maxS) maxS = s;
+	if (exact32)
+		thresholdBand<int>(im, output, option, p, r0, r1, a, imSum, imSumSq, maxOnly);
+	else
+		thresholdBand<double>(im, output, option, p, r0, r1, a, imSum, imSumSq, maxOnly);
+}
 
-		float *mapMData = mapM.ptr<float>(j) + xFirstth;
-		float *mapSData = mapS.ptr<float>(j) + xFirstth;
-		*mapMData++ = m;
-		*mapSData++ = s;
+void Binarization::thresholdImg(Mat im, Mat &output, int option, int winx, int winy, double k, double dR){
 
-		for	(int i=1 ; i<=im.cols-winx; i++) {
-			sumTopLeft++, sumTopRight++, sumBottomLeft++, sumBottomRight++;
+	if (option > 1){
+		ThresholdParams p;
+		p.winx = winx;
+		p.winy = winy;
+		p.k = k;
+		p.dR = dR;
+		p.maxS = 0;
+		p.minI = 0;
+
+		output.create(im.rows, im.cols, CV_8U);
+		if (option > BINARIZE_BRADLEY){
+			output.setTo(255);
+			return;
+		}
 
-			sumEqTopLeft++, sumEqTopRight++, sumEqBottomLeft++, sumEqBottomRight++;
+		// With tileRows > 0 the integral images only cover a band of rows plus
+		// the window height, which gives the same result with bounded memory
+		int bandRows = this->tileRows > 0 ? this->tileRows : im.rows;
 
-			sum = (*sumBottomRight + *sumTopLeft) - (*sumTopRight + *sumBottomLeft);
-			sumSq = (*sumEqBottomRight + *sumEqTopLeft) - (*sumEqTopRight + *sumEqBottomLeft);
+		if (option == BINARIZE_WOLF){
+			double maxI;
+			minMaxLoc(im, &p.minI, &maxI);
+			for (int r0=0; r0<im.rows; r0+=bandRows)
+				localBand(im, output, option, p, r0, min(r0+bandRows, im.rows), true);
+		}
+		for (int r0=0; r0<im.rows; r0+=bandRows)
+			localBand(im, output, option, p, r0, min(r0+bandRows, im.rows), false);
 
-			m  = sum / winarea;
-			s  = sqrt ((sumSq - m*sum)/winarea);
-			if (s > maxS) maxS = s;
+	} else if (option == 1){
+		Mat smoothedImg;
+		blur(im, smoothedImg, Size(3,3), Point(-1,-1));
+		threshold(smoothedImg, output, 0.0, 255, THRESH_BINARY | THRESH_OTSU);
 
-			*mapMData++ = m;
-			*mapSData++ = s;
-		}
+	} else {
+		threshold(im, output, 127, 255, THRESH_BINARY);
 	}
-	return maxS;
 }
 
-void Binarization::lightDistribution(Mat &grayscale){
-	getHistogram(grayscale);
-	getCEI(grayscale);
-	getEdge(grayscale);
-	getTLI(grayscale);
-
-    Mat intImg = this->cei.clone();
-
-    for (int y=0; y<intImg.cols; y++){
-        for (int x=0; x<intImg.rows; x++){
+// Gaps of at most maxGap pixels in a column of the eroded text line mask are
+// interpolated from the max contrast of the window pixels at the head and the
+// end of the gap. A pixel at distance d from the end of its gap ends up
+// with maxH + (maxE - maxH) / d, where maxH is taken at the pixel itself,
+// so the columns can be handled bottom-up, one row at a time.
+Mat Binarization::fillGaps(Mat cei, int maxGap, int window){
+    Mat intImg = cei.clone();
+    Mat maxHead, maxEnd;
+    dilate(cei, maxHead, Mat::ones(window, 1, CV_8U), Point(0, window-1));
+    dilate(cei, maxEnd, Mat::ones(window, 1, CV_8U), Point(0, 0));
+    vector<int> gap(intImg.cols, 0);
+    vector<float> gapEnd(intImg.cols, 0);
+
+    for (int y=intImg.rows-1; y>=0; y--){
+        const float *tliData = this->tliErosion.ptr<float>(y);
+        const float *headData = maxHead.ptr<float>(y);
+        const float *endData = maxEnd.ptr<float>(y);
+        float *intData = intImg.ptr<float>(y);
+
+        for (int x=0; x<intImg.cols; x++){
+            if (tliData[x] != 0){
+                gap[x] = 0;
+                continue;
+            }
+            if (gap[x] == 0)
+                gapEnd[x] = endData[x];
 
-            if (this->tliErosion.at<float>(x,y) == 0){
-                int head = x, end = x, n;
+            int d = ++gap[x];
+            if (d <= maxGap){
+                double maxH = headData[x];
+                intData[x] = maxH + (gapEnd[x] - maxH) / d;
+            }
+        }
+    }
+    return intImg;
+}
 
-                while (end < this->tliErosion.rows && this->tliErosion.at<float>(end,y) == 0){
-                    end++;
-                }
-                end--;
-                n = end - head + 1;
+void Binarization::lightDistribution(Mat &grayscale, double lightScale){
+	getHistogram(grayscale);
+	getCEI(grayscale);
 
-                if (n <= 30){
-                    vector<float> mpvH, mpvE;
-                    double minH, maxH, minE, maxE;
+    // The light distribution changes slowly over the page, with lightScale < 1
+    // it is estimated on a downscaled image and upsampled afterwards. The gap
+    // length, the head/end windows and the averaging window shrink along.
+    Mat cei = this->cei;
+    Mat small = grayscale;
+    if (lightScale > 0 && lightScale < 1){
+        Size smallSize(max(1, cvRound(grayscale.cols * lightScale)), max(1, cvRound(grayscale.rows * lightScale)));
+        resize(grayscale, small, smallSize, 0, 0, INTER_AREA);
+        resize(this->cei, cei, small.size(), 0, 0, INTER_AREA);
+    } else {
+        lightScale = 1;
+    }
+    int maxGap = max(1, cvRound(30 * lightScale));
+    int window = max(1, cvRound(5 * lightScale));
+    int ksize = max(1, cvRound(11 * lightScale)) | 1;
+
+	getEdge(small);
+	getTLI(cei);
+    if (!this->introspection){
+        this->ceiBin.release();
+        this->egBin.release();
+        this->tli.release();
+    }
 
-                    for (int k=0; k<5; k++){
-                        if ((head - k) >= 0)
-                            mpvH.push_back(this->cei.at<float>(head-k,y));
-                        if ((end + k) < this->cei.rows)
-                            mpvE.push_back(this->cei.at<float>(end+k,y));
-                    }
+    Mat intImg = fillGaps(cei, maxGap, window);
+    cei.release();
 
-                    minMaxLoc(mpvH, &minH, &maxH);
-                    minMaxLoc(mpvE, &minE, &maxE);
+    blur(scale(intImg), this->ldi, Size(ksize, ksize));
+    intImg.release();
 
-                    for (int m=0; m<n; m++)
-                        intImg.at<float>(head+m,y) = maxH + (m+1) * ((maxE-maxH) / n);
-                }
-            }
-        }
+    Mat textMask = this->tliErosion != 0;
+    if (!this->introspection)
+        this->tliErosion.release();
+    if (lightScale < 1){
+        resize(this->ldi, this->ldi, grayscale.size(), 0, 0, INTER_LINEAR);
+        resize(textMask, textMask, grayscale.size(), 0, 0, INTER_NEAREST);
     }
 
-    Mat kernel = Mat::ones(Size(11, 11), CV_32F) * 1/121;
-    filter2D(scale(intImg), this->ldi, CV_32F, kernel);
-
     grayscale = (this->cei/this->ldi) * 260;
-
-    for (int y=0; y<this->tliErosion.rows; y++){
-        for (int x=0; x<this->tliErosion.cols; x++){
-            if (this->tliErosion.at<float>(y,x) != 0)
-                grayscale.at<float>(y,x) *= 1.5;
-        }
+    Mat boosted = grayscale * 1.5;
+    boosted.copyTo(grayscale, textMask);
+    boosted.release();
+    textMask.release();
+    if (!this->introspection){
+        this->histogram.release();
+        this->cei.release();
+        this->ldi.release();
     }
 
     GaussianBlur(grayscale, grayscale, Size(3,3), 2);
@@ -286,42 +423,64 @@ void Binarization::getHR(float sqrtHW){
 void Binarization::getCEI(Mat grayscale){
     Mat cei = (grayscale - (this->hr + 50 * 0.4)) * 2;
     normalize(cei, this->cei, 0, 255, NORM_MINMAX, CV_32F);
-    threshold(this->cei, this->ceiBin, 59, 255, THRESH_BINARY_INV);
 }
 
-void Binarization::getEdge(Mat grayscale){
-    float m1[] = {-1,0,1,-2,0,2,-1,0,1};
-    float m2[] = {-2,-1,0,-1,0,1,0,1,2};
-    float m3[] = {-1,-2,-1,0,0,0,1,2,1};
-    float m4[] = {0,1,2,-1,0,1,-2,-1,0};
-
-    Mat kernel1(3, 3, CV_32F, m1);
-    Mat kernel2(3, 3, CV_32F, m2);
-    Mat kernel3(3, 3, CV_32F, m3);
-    Mat kernel4(3, 3, CV_32F, m4);
-
-    Mat eg1, eg2, eg3, eg4;
-    filter2D(grayscale, eg1, CV_32F, kernel1);
-    eg1 = abs(eg1);
-
-    filter2D(grayscale, eg2, CV_32F, kernel2);
-    eg2 = abs(eg2);
+// Sum of the absolute responses of the four directional 3x3 edge kernels
+// (horizontal, vertical and both diagonals) at column x of the rows r0, r1, r2
+static inline int edgeResponse(const uchar *r0, const uchar *r1, const uchar *r2, int xl, int x, int xr){
+    int e1 = (r0[xr] + 2*r1[xr] + r2[xr]) - (r0[xl] + 2*r1[xl] + r2[xl]);
+    int e2 = (r1[xr] + r2[x] + 2*r2[xr]) - (2*r0[xl] + r0[x] + r1[xl]);
+    int e3 = (r2[xl] + 2*r2[x] + r2[xr]) - (r0[xl] + 2*r0[x] + r0[xr]);
+    int e4 = (r0[x] + 2*r0[xr] + r1[xr]) - (r1[xl] + 2*r2[xl] + r2[x]);
+    return abs(e1) + abs(e2) + abs(e3) + abs(e4);
+}
 
-    filter2D(grayscale, eg3, CV_32F, kernel3);
-    eg3 = abs(eg3);
+void Binarization::getEdge(Mat grayscale){
+    int rows = grayscale.rows, cols = grayscale.cols;
+    Mat edges(rows, cols, CV_16U);
+    int minE = INT_MAX, maxE = 0;
+
+    for (int y=0; y<rows; y++){
+        const uchar *r0 = grayscale.ptr<uchar>(borderInterpolate(y-1, rows, BORDER_REFLECT_101));
+        const uchar *r1 = grayscale.ptr<uchar>(y);
+        const uchar *r2 = grayscale.ptr<uchar>(borderInterpolate(y+1, rows, BORDER_REFLECT_101));
+        ushort *edgesData = edges.ptr<ushort>(y);
+
+        for (int x=0; x<cols; x++){
+            int xl = x-1, xr = x+1;
+            if (x == 0 || x == cols-1){
+                xl = borderInterpolate(xl, cols, BORDER_REFLECT_101);
+                xr = borderInterpolate(xr, cols, BORDER_REFLECT_101);
+            }
+            int e = edgeResponse(r0, r1, r2, xl, x, xr);
+            edgesData[x] = (ushort)e;
+            if (e < minE) minE = e;
+            if (e > maxE) maxE = e;
+        }
+    }
 
-    filter2D(grayscale, eg4, CV_32F, kernel4);
-    eg4 = abs(eg4);
+    // scale() of the average response followed by a threshold at 30, done on
+    // the integer sums: (e - minE) * 255 / (maxE - minE) > 30
+    if (maxE > minE){
+        compare(edges, minE + (2 * (maxE - minE)) / 17, this->egBin, CMP_GT);
+    } else {
+        this->egBin = Mat::zeros(rows, cols, CV_8U);
+    }
 
-    this->egAvg = scale((eg1 + eg2 + eg3 + eg4)/4);
-    threshold(this->egAvg, this->egBin, 30, 255, THRESH_BINARY);
+    if (this->introspection){
+        Mat egAvg;
+        edges.convertTo(egAvg, CV_32F, 0.25);
+        this->egAvg = scale(egAvg);
+    } else {
+        this->egAvg.release();
+    }
 }
 
-void Binarization::getTLI(Mat grayscale){
-    this->tli = Mat::ones(Size(grayscale.cols, grayscale.rows), CV_32F) * 255;
-    this->tli -= this->egBin;
-    this->tli -= this->ceiBin;
-    threshold(this->tli, this->tli, 0, 255, THRESH_BINARY);
+void Binarization::getTLI(Mat cei){
+    threshold(cei, this->ceiBin, 59, 255, THRESH_BINARY_INV);
+
+    this->tli = Mat::zeros(cei.rows, cei.cols, CV_32F);
+    this->tli.setTo(255, (this->egBin == 0) & (this->ceiBin == 0));
 
     Mat kernel = Mat::ones(Size(3, 3), CV_32F);
     erode(this->tli, this->tliErosion, kernel);
@@ -5,10 +5,25 @@
 using namespace cv;
 using namespace std;
 
+enum BinarizationMethod {
+    BINARIZE_THRESHOLD = 0,
+    BINARIZE_OTSU = 1,
+    BINARIZE_NIBLACK = 2,
+    BINARIZE_SAUVOLA = 3,
+    BINARIZE_WOLF = 4,
+    BINARIZE_BRADLEY = 5
+};
+
 class Binarization {
     public:
         Binarization();
-        void binarize(Mat image, Mat &output, bool light, int option);
+        void binarize(Mat image, Mat &output, bool light, int option, double lightScale = 1.0);
+
+        // keep the intermediate images of the light distribution (cei, egAvg, tli, ldi, ...) after binarize
+        // for inspection, by default they are released as soon as they are no longer needed
+        bool introspection;
+        // local thresholds in bands of this many rows, 0 for the whole image at once
+        int tileRows;
 
         float hr;
         Mat histogram;
@@ -25,11 +40,11 @@ class Binarization {
         void getHR(float sqrtHW);
         void getCEI(Mat grayscale);
         void getEdge(Mat grayscale);
-        void getTLI(Mat grayscale);
+        void getTLI(Mat cei);
 
-        void lightDistribution(Mat &grayscale);
+        void lightDistribution(Mat &grayscale, double lightScale);
+        Mat fillGaps(Mat cei, int maxGap, int window);
         void thresholdImg(Mat im, Mat &output, int option, int winx, int winy, double k, double dR);
 
-        double calcLocalStats(Mat &im, Mat &mapM, Mat &mapS, int winx, int winy);
         Mat scale(Mat image);
 };
@@ -0,0 +1,39 @@
+#include "BoxGrid.hpp"
+
+BoxGrid::BoxGrid(): cellSize(64), gridCols(0), gridRows(0) {}
+
+void BoxGrid::build(const vector<Rect> &boxes, Size size, int cellSize) {
+    this->cellSize = max(1, cellSize);
+    this->gridCols = max(1, (size.width + this->cellSize - 1) / this->cellSize);
+    this->gridRows = max(1, (size.height + this->cellSize - 1) / this->cellSize);
+    this->boxes = boxes;
+    this->cells.assign(gridCols * gridRows, vector<int>());
+
+    for (size_t i=0; i<boxes.size(); i++) {
+        Rect r = boxes[i] & Rect(0, 0, gridCols * this->cellSize, gridRows * this->cellSize);
+        if (r.empty()) continue;
+
+        for (int cy=r.y / this->cellSize; cy<=(r.y + r.height - 1) / this->cellSize; cy++)
+            for (int cx=r.x / this->cellSize; cx<=(r.x + r.width - 1) / this->cellSize; cx++)
+                cells[cy * gridCols + cx].push_back((int) i);
+    }
+}
+
+// returns the ids of the boxes intersecting the region, in increasing order
+vector<int> BoxGrid::query(Rect region) const {
+    vector<int> found;
+    Rect r = region & Rect(0, 0, gridCols * cellSize, gridRows * cellSize);
+    if (r.empty()) return found;
+
+    for (int cy=r.y / cellSize; cy<=(r.y + r.height - 1) / cellSize; cy++) {
+        for (int cx=r.x / cellSize; cx<=(r.x + r.width - 1) / cellSize; cx++) {
+            for (int id : cells[cy * gridCols + cx]) {
+                if ((boxes[id] & region).area() > 0)
+                    found.push_back(id);
+            }
+        }
+    }
+    sort(found.begin(), found.end());
+    found.erase(unique(found.begin(), found.end()), found.end());
+    return found;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <opencv2/imgproc/imgproc.hpp>
+
+using namespace cv;
+using namespace std;
+
+// Uniform grid over a set of boxes to look up the boxes touching a region.
+class BoxGrid {
+    public:
+        BoxGrid();
+
+        void build(const vector<Rect> &boxes, Size size, int cellSize = 64);
+        vector<int> query(Rect region) const;
+
+    private:
+        int cellSize;
+        int gridCols;
+        int gridRows;
+        vector<vector<int>> cells;
+        vector<Rect> boxes;
+};
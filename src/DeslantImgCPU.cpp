@@ -1,5 +1,7 @@
 #include "DeslantImgCPU.hpp"
+#include "Workspace.hpp"
 #include <opencv2/imgproc.hpp>
+#include <opencv2/core/utility.hpp>
 #include <vector>
 #include <assert.h>
 #include <algorithm>
@@ -8,104 +10,254 @@
 namespace htr
 {
 
-	// data structure for internal usage
-	struct Result
+	// foreground pixels of a binary image, collected once to score shear values without warping
+	class ShearStats
 	{
-		float sum_alpha = 0.0f;
-		cv::Mat transform;
-		cv::Size size;
-		bool operator < (const Result& rhs) const { return sum_alpha < rhs.sum_alpha; }
-	};
-
-
-	// deslant image containing text (remove italic style)
-	// * img: grayscale image containing text
-	// * bgcolor: empty space in result image is filled with this color (0...255)
-	// * returns: deslanted image
-	cv::Mat deslantImg(const cv::Mat& img, const int bgcolor, const float lower_bound, const float upper_bound)
-	{
-		// must be grayscale img
-		assert(img.channels() == 1);
-
-		// calc binary img
-		cv::Mat imgBW;
-		cv::threshold(img, imgBW, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+	public:
+		explicit ShearStats(const cv::Mat& imgBW)
+			: rows(imgBW.rows), cols(imgBW.cols), rowStart(imgBW.rows + 1, 0)
+		{
+			for (int y = 0; y < rows; ++y)
+			{
+				const unsigned char* data = imgBW.ptr<unsigned char>(y);
+				for (int x = 0; x < cols; ++x)
+				{
+					if (data[x])
+					{
+						fgCols.push_back(x);
+					}
+				}
+				rowStart[y + 1] = static_cast<int>(fgCols.size());
+			}
+		}
 
-		// list of alpha values controlling shear transform (search space)
-		std::vector<float> alphaVals = { -1.0, -0.75, -0.5, -0.25, 0.0, 0.25, 0.5, 0.75, 1.0 };
+		// sum of h_alpha^2 over the cols of the sheared image where all fg pixels are connected
+		// (variable names according to paper Vinciarelli)
+		double sumAlpha(const float alpha)
+		{
+			const float shiftX = std::max(-alpha*rows, 0.0f);
+			const int width = cols + static_cast<int>(std::ceil(std::abs(alpha*rows)));
 
-		// variable names according to paper Vinciarelli
-		std::vector<int> sum_alpha(alphaVals.size(), 0);
+			// reuse the buffers of the previous alpha
+			count.assign(width, 0);
+			first.resize(width);
+			last.resize(width);
 
-		// go through alpha values to see which is best for deslanting
-		std::vector<Result> results;
-		for (size_t i = 0; i < alphaVals.size(); ++i)
-		{
-			Result result;
-
-			const float alpha = alphaVals[i];
-			if (alpha < lower_bound)
-				continue;
-			if (alpha > upper_bound)
-				break;
-			const float shiftX = std::max(-alpha*imgBW.rows, 0.0f);
-			result.size = cv::Size(imgBW.cols + static_cast<int>(std::ceil(std::abs(alpha*imgBW.rows))), imgBW.rows);
-
-			// transformation matrix (2x3)
-			// x'=M00*x+M01*y+M02
-			// y'=M10*x+M11*y+M12
-			result.transform = cv::Mat(2, 3, CV_32F);
-			result.transform.at<float>(0, 0) = 1;
-			result.transform.at<float>(0, 1) = alpha;
-			result.transform.at<float>(0, 2) = shiftX;
-			result.transform.at<float>(1, 0) = 0;
-			result.transform.at<float>(1, 1) = 1;
-			result.transform.at<float>(1, 2) = 0;
-			cv::Mat imgSheared;
-
-			// shear image
-			cv::warpAffine(imgBW, imgSheared, result.transform, result.size, cv::INTER_NEAREST);
-
-			// go through all cols
-			for (int x = 0; x < imgSheared.cols; ++x)
+			for (int y = 0; y < rows; ++y)
 			{
-				// calc h_alpha and delta_y_alpha 
-				std::vector<int> fgIndices;
-				for (int y = 0; y < imgSheared.rows; ++y)
+				// col offset of row y, rounded the same way as warpAffine with INTER_NEAREST
+				const double srcOffset = -static_cast<double>(alpha)*y - shiftX;
+				const int offset = -cvFloor((cvRound(srcOffset * 1024) + 512) / 1024.0);
+
+				for (int i = rowStart[y]; i < rowStart[y + 1]; ++i)
 				{
-					if (imgSheared.at<unsigned char>(y, x))
+					const int x = fgCols[i] + offset;
+					if (x < 0 || x >= width)
+					{
+						continue;
+					}
+					if (count[x]++ == 0)
 					{
-						fgIndices.push_back(y);
+						first[x] = y;
 					}
+					last[x] = y;
 				}
+			}
 
-				// no fg pixels ... nothing to do
-				if (fgIndices.empty())
+			double sum = 0;
+			for (int x = 0; x < width; ++x)
+			{
+				const int h_alpha = count[x]; // number of fg pixels in col
+				if (h_alpha == 0)
 				{
 					continue;
 				}
-
-				// variable names according to paper Vinciarelli
-				int h_alpha = static_cast<int>(fgIndices.size()); // number of fg pixels in col
-				int delta_y_alpha = fgIndices.back() - fgIndices.front() + 1; // distance between first and last fg pixel in col (+1 to avoid getting Float.Inf)
+				const int delta_y_alpha = last[x] - first[x] + 1; // distance between first and last fg pixel in col
 
 				// if H_alpha (=h_alpha/delta_y_alpha) == 1
 				if (h_alpha == delta_y_alpha)
 				{
-					result.sum_alpha += h_alpha*h_alpha;
+					sum += static_cast<double>(h_alpha)*h_alpha;
 				}
 			}
+			return sum;
+		}
+
+	private:
+		int rows, cols;
+		std::vector<int> fgCols; // col of each fg pixel, row by row
+		std::vector<int> rowStart; // offset of each row in fgCols
+		std::vector<int> count, first, last;
+	};
+
 
-			results.push_back(result);
+	float deslantAlpha(const cv::Mat& imgBW, const float lower_bound, const float upper_bound, const float precision)
+	{
+		ShearStats stats(imgBW);
+		float bestAlpha = 0.0f;
+		double bestSum = -1;
+		auto score = [&](const float alpha)
+		{
+			const double sum = stats.sumAlpha(alpha);
+			if (sum > bestSum)
+			{
+				bestSum = sum;
+				bestAlpha = alpha;
+			}
+			return sum;
+		};
+
+		// coarse grid (search space), the midpoint if no grid value is within the bounds
+		const float step = 0.25f;
+		const std::vector<float> searchSpace = { -1.0, -0.75, -0.5, -0.25, 0.0, 0.25, 0.5, 0.75, 1.0 };
+		for (size_t i = 0; i < searchSpace.size(); ++i)
+		{
+			if (searchSpace[i] >= lower_bound && searchSpace[i] <= upper_bound)
+			{
+				score(searchSpace[i]);
+			}
+		}
+		if (bestSum < 0)
+		{
+			score((lower_bound + upper_bound) / 2);
+		}
+		if (precision <= 0)
+		{
+			return bestAlpha;
 		}
 
-		// use best result to transform image
-		Result bestResult = *std::max_element(results.begin(), results.end());
-		cv::Mat imgDeslanted;
-		cv::warpAffine(img, imgDeslanted, bestResult.transform, bestResult.size, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(bgcolor));
+		// golden-section search in the neighbourhood of the best grid value
+		const double invPhi = (std::sqrt(5.0) - 1) / 2;
+		double a = std::max<double>(lower_bound, bestAlpha - step);
+		double b = std::min<double>(upper_bound, bestAlpha + step);
+		double c = b - invPhi * (b - a);
+		double d = a + invPhi * (b - a);
+		double fc = score(static_cast<float>(c));
+		double fd = score(static_cast<float>(d));
+		while (b - a > precision)
+		{
+			if (fc >= fd)
+			{
+				b = d;
+				d = c;
+				fd = fc;
+				c = b - invPhi * (b - a);
+				fc = score(static_cast<float>(c));
+			}
+			else
+			{
+				a = c;
+				c = d;
+				fc = fd;
+				d = a + invPhi * (b - a);
+				fd = score(static_cast<float>(d));
+			}
+		}
+		return bestAlpha;
+	}
+
+
+	cv::Mat shearImg(const cv::Mat& img, const float alpha, const int bgcolor)
+	{
+		const float shiftX = std::max(-alpha*img.rows, 0.0f);
+		const cv::Size size(img.cols + static_cast<int>(std::ceil(std::abs(alpha*img.rows))), img.rows);
 
-		return imgDeslanted;
+		// transformation matrix (2x3)
+		// x'=M00*x+M01*y+M02
+		// y'=M10*x+M11*y+M12
+		cv::Mat transform(2, 3, CV_32F);
+		transform.at<float>(0, 0) = 1;
+		transform.at<float>(0, 1) = alpha;
+		transform.at<float>(0, 2) = shiftX;
+		transform.at<float>(1, 0) = 0;
+		transform.at<float>(1, 1) = 1;
+		transform.at<float>(1, 2) = 0;
+
+		cv::Mat imgSheared;
+		cv::warpAffine(img, imgSheared, transform, size, cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(bgcolor));
+		return imgSheared;
 	}
 
-}
 
+	// find the shear value of an image containing text, without deslanting it
+	// * img: grayscale image containing text, binarized with Otsu in the scratch space of the thread
+	// * lower_bound, upper_bound, precision: see deslantAlpha
+	// * returns: shear value which puts the text upright, 0 for an empty image
+	float deslantImgAlpha(const cv::Mat& img, const float lower_bound, const float upper_bound, const float precision)
+	{
+		// must be grayscale img
+		assert(img.channels() == 1);
+
+		if (img.empty())
+		{
+			return 0.0f;
+		}
+
+		// calc binary img, in the scratch space of the thread
+		cv::Mat imgBW = Workspace::local().get("deslant.bw", img.rows, img.cols, CV_8U);
+		cv::threshold(img, imgBW, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+
+		return deslantAlpha(imgBW, lower_bound, upper_bound, precision);
+	}
+
+
+	// deslant image containing text (remove italic style)
+	// * img: grayscale image containing text
+	// * bgcolor: empty space in result image is filled with this color (0...255)
+	// * alpha: if not null, receives the shear value
+	// * returns: deslanted image
+	cv::Mat deslantImg(const cv::Mat& img, const int bgcolor, const float lower_bound, const float upper_bound, const float precision, float* alpha)
+	{
+		const float bestAlpha = deslantImgAlpha(img, lower_bound, upper_bound, precision);
+		if (alpha)
+		{
+			*alpha = bestAlpha;
+		}
+		if (img.empty())
+		{
+			return img.clone();
+		}
+
+		// use best alpha to transform image
+		return shearImg(img, bestAlpha, bgcolor);
+	}
+
+
+	// deslants the images of a range, each image is independent of the others
+	class DeslantBody : public cv::ParallelLoopBody
+	{
+	public:
+		DeslantBody(std::vector<cv::Mat>& imgs, std::vector<float>& alphas, const bool warp, const int bgcolor, const float lower_bound, const float upper_bound, const float precision)
+			: imgs(imgs), alphas(alphas), warp(warp), bgcolor(bgcolor), lower_bound(lower_bound), upper_bound(upper_bound), precision(precision) {}
+
+		void operator()(const cv::Range& range) const
+		{
+			for (int i = range.start; i < range.end; ++i)
+			{
+				if (warp)
+				{
+					imgs[i] = deslantImg(imgs[i], bgcolor, lower_bound, upper_bound, precision, &alphas[i]);
+				}
+				else
+				{
+					alphas[i] = deslantImgAlpha(imgs[i], lower_bound, upper_bound, precision);
+				}
+			}
+		}
+
+	private:
+		std::vector<cv::Mat>& imgs;
+		std::vector<float>& alphas;
+		const bool warp;
+		const int bgcolor;
+		const float lower_bound, upper_bound, precision;
+	};
+
+
+	void deslantImgs(std::vector<cv::Mat>& imgs, std::vector<float>& alphas, const bool warp, const int bgcolor, const float lower_bound, const float upper_bound, const float precision)
+	{
+		alphas.assign(imgs.size(), 0.0f);
+		cv::parallel_for_(cv::Range(0, static_cast<int>(imgs.size())), DeslantBody(imgs, alphas, warp, bgcolor, lower_bound, upper_bound, precision));
+	}
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <opencv2/core.hpp>
+#include <vector>
 
 
 namespace htr
@@ -8,8 +9,26 @@ namespace htr
 	// deslant image containing text (remove italic style)
 	// * img: grayscale image containing text
 	// * bgcolor: empty space in result image is filled with this color (0...255)
+	// * precision: if > 0, refine the best shear value of the grid up to this precision
+	// * alpha: if given, receives the shear value which was used
 	// * returns: deslanted image
-	cv::Mat deslantImg(const cv::Mat& img, const int bgcolor, const float lower_bound=-1.0, const float upper_bound=1.0);
+	cv::Mat deslantImg(const cv::Mat& img, const int bgcolor, const float lower_bound=-1.0, const float upper_bound=1.0, const float precision=0.0, float* alpha=nullptr);
 
-}
+	// find the shear value in [lower_bound, upper_bound] which puts the text upright
+	// searches the grid -1.0, -0.75, ..., 1.0 and, if precision > 0, refines the best value with a golden-section search
+	// * imgBW: binary image, foreground (text) pixels are non zero
+	float deslantAlpha(const cv::Mat& imgBW, const float lower_bound, const float upper_bound, const float precision);
+
+	// find the shear value which puts the text of a grayscale image upright, without deslanting it
+	float deslantImgAlpha(const cv::Mat& img, const float lower_bound=-1.0, const float upper_bound=1.0, const float precision=0.0);
+
+	// deslant a set of images in parallel
+	// * imgs: grayscale images, replaced by the deslanted images if warp is true
+	// * alphas: receives the shear value of each image
+	void deslantImgs(std::vector<cv::Mat>& imgs, std::vector<float>& alphas, const bool warp, const int bgcolor, const float lower_bound=-1.0, const float upper_bound=1.0, const float precision=0.0);
 
+	// shear image horizontally: x' = x + alpha*y (shifted to keep all pixels in the image)
+	// * bgcolor: empty space in result image is filled with this color (0...255)
+	cv::Mat shearImg(const cv::Mat& img, const float alpha, const int bgcolor);
+
+}
@@ -1,14 +1,40 @@
 #include "LineSegmentation.hpp"
 
+const vector<int> LineSegmentation::primes = LineSegmentation::sieve();
+
 LineSegmentation::LineSegmentation() {
     this->avgLineHeight = 0;
-    sieve();
+    this->overview = true;
+}
+
+LineSegmentation::~LineSegmentation() {
+    deleteRegions();
+    for (auto line : this->initialLines)
+        delete line;
+    for (auto chunk : this->chunks)
+        delete chunk;
+    for (auto &valley : this->mapValley)
+        delete valley.second;
+}
+
+// Every region is above or below one of the lines, also the ones which are not kept in lineRegions
+void LineSegmentation::deleteRegions() {
+    set<Region *> regions;
+    for (auto line : this->initialLines) {
+        regions.insert(line->above);
+        regions.insert(line->below);
+        line->above = line->below = nullptr;
+    }
+    for (auto region : regions)
+        delete region;
+    this->lineRegions.clear();
 }
 
-void LineSegmentation::segment(Mat &input, vector<Mat> &output, int chunksNumber, int chunksProcess) {
+void LineSegmentation::segment(Mat &input, vector<Mat> &output, int chunksNumber, int chunksProcess, bool overview, int deslanting) {
     this->binaryImg = input.clone();
     this->chunksNumber = chunksNumber;
     this->chunksToProcess = chunksProcess;
+    this->overview = overview;
 
     getContours();
     generateChunks();
@@ -18,20 +44,21 @@ void LineSegmentation::segment(Mat &input, vector<Mat> &output, int chunksNumber
         generateRegions();
         repairLines();
         generateRegions();
-        printLines(input);
+        if (overview)
+            printLines(input);
         getRegions(output);
     } else {
-        output.push_back(input);
+        output.push_back(this->binaryImg);
     }
 
-    for(unsigned int i=0; i<output.size(); i++)
-        deslant(output[i], output[i], 255);
+    this->alphas.clear();
+    if (deslanting != DESLANT_NONE)
+        htr::deslantImgs(output, this->alphas, deslanting == DESLANT_IMAGE, 255);
 }
 
-void LineSegmentation::sieve() {
-    for (int i=0; i<1e5; ++i) {
-        notPrimesArr[i] = false;
-    }
+vector<int> LineSegmentation::sieve() {
+    vector<bool> notPrimesArr(100000, false);
+    vector<int> primes;
     notPrimesArr[0] = notPrimesArr[1] = true;
     for (int i=2; i<1e5; ++i) {
         if (notPrimesArr[i]) continue;
@@ -41,6 +68,7 @@ void LineSegmentation::sieve() {
             notPrimesArr[j] = true;
         }
     }
+    return primes;
 }
 
 void LineSegmentation::addPrimesToVector(int n, vector<int> &probPrimes) {
@@ -71,46 +99,26 @@ void LineSegmentation::printLines(Mat &inputOutput) {
 }
 
 void LineSegmentation::getContours() {
-    vector<vector<Point>> contours;
-    vector<Vec4i> hierarchy;
-    findContours(this->binaryImg, contours, hierarchy, RETR_LIST, CHAIN_APPROX_NONE, Point(0, 0));
-
-    vector<vector<Point>> contoursPoly(contours.size());
-    vector<Rect> boundRect(contours.size()-1);
-
-    for (size_t i=0; i<contours.size()-1; i++) {
-        approxPolyDP(Mat(contours[i]), contoursPoly[i], 1, true);
-        boundRect[i] = boundingRect(Mat(contoursPoly[i]));
+    // the boxes of the 4-connected ink components grown by 1px, as the hole contours of the
+    // white background found by findContours were
+    Mat labels, stats, centroids;
+    int n = connectedComponentsWithStats(this->binaryImg == 0, labels, stats, centroids, 4, CV_32S);
+    Rect page(0, 0, this->binaryImg.cols, this->binaryImg.rows);
+    vector<Rect> boundRect;
+    for (int i=1; i<n; i++) {
+        const int *s = stats.ptr<int>(i);
+        boundRect.push_back(Rect(s[CC_STAT_LEFT] - 1, s[CC_STAT_TOP] - 1, s[CC_STAT_WIDTH] + 2, s[CC_STAT_HEIGHT] + 2) & page);
     }
 
-    Rect_<double> rectangle3;
-    vector<Rect> mergedRectangles;
-    bool isRepeated;
-    cvtColor(this->binaryImg, this->contoursDrawing, COLOR_GRAY2BGR);
-
-    for (unsigned int i=0; i<boundRect.size(); i++) {
-        isRepeated = false;
+    vector<Rect> mergedRectangles = mergeNestedRects(boundRect);
 
-        for (unsigned int j=i+1; j<boundRect.size(); j++) {
-            rectangle3 = boundRect[i] & boundRect[j];
-
-            if ((rectangle3.area() == boundRect[i].area()) || (rectangle3.area() == boundRect[j].area())) {
-                isRepeated = true;
-                rectangle3 = boundRect[i] | boundRect[j];
-                Rect_<double> mergedRectangle(rectangle3.tl().x, rectangle3.tl().y, rectangle3.width, rectangle3.height);
-
-                if (j == boundRect.size() - 2)
-                    mergedRectangles.push_back(mergedRectangle);
-
-                boundRect[j] = mergedRectangle;
-            }
-        }
-        if (!isRepeated)
-            mergedRectangles.push_back(boundRect[i]);
+    if (this->overview) {
+        cvtColor(this->binaryImg, this->contoursDrawing, COLOR_GRAY2BGR);
+        for (size_t i=0; i<mergedRectangles.size(); i++)
+            rectangle(this->contoursDrawing, mergedRectangles[i].tl(), mergedRectangles[i].br(), cv::Scalar(0,0,255), 2, 8, 0);
     }
-    for (size_t i=0; i<mergedRectangles.size(); i++)
-        rectangle(this->contoursDrawing, mergedRectangles[i].tl(), mergedRectangles[i].br(), cv::Scalar(0,0,255), 2, 8, 0);
     this->contours = mergedRectangles;
+    this->contoursGrid.build(this->contours, this->binaryImg.size());
 }
 
 
@@ -155,6 +163,8 @@ void LineSegmentation::getInitialLines() {
 
             if (newLine->valleysID.size() > 1)
                 this->initialLines.push_back(newLine);
+            else
+                delete newLine;
         }
     }
 }
@@ -189,7 +199,7 @@ Line * LineSegmentation::connectValleys(int i, Valley *currentValley, Line *line
 
 void LineSegmentation::generateRegions() {
     sort(this->initialLines.begin(), this->initialLines.end(), Line::compMinRowPosition);
-    this->lineRegions = vector<Region *>();
+    deleteRegions();
 
     Region *r = new Region(nullptr, this->initialLines[0]);
     r->updateRegion(this->binaryImg, 0);
@@ -259,7 +269,8 @@ void LineSegmentation::repairLines() {
             if (columnProcessed[y]) continue;
             columnProcessed[y] = true;
 
-            for (auto contour : this->contours) {
+            for (int id : this->contoursGrid.query(Rect(y - 1, x - 1, 3, 3))) {
+                Rect &contour = this->contours[id];
                 if (y >= contour.tl().x && y <= contour.br().x && x >= contour.tl().y && x <= contour.br().y) {
                     if (contour.br().y - contour.tl().y > this->avgLineHeight * 0.9) continue;
 
@@ -331,62 +342,12 @@ void LineSegmentation::getRegions(vector<Mat> &output) {
     output = ret;
 }
 
-struct Result {
-    float sumAlpha = 0.0f;
-    Mat transform;
-    Size size;
-    bool operator < (const Result& rhs) const { return sumAlpha < rhs.sumAlpha; }
-};
-
-void LineSegmentation::deslant(Mat image, Mat &output, int bgcolor){
-    vector<float> alphaVals = {-1.0, -0.75, -0.5, -0.25, 0.0, 0.25, 0.5, 0.75, 1.0};
-    vector<int> sumAlpha(alphaVals.size(), 0);
-	vector<Result> results;
-
-	for (size_t i=0; i<alphaVals.size(); ++i){
-        Result result;
-		const float alpha = alphaVals[i];
-		const float shiftX = max(-alpha*image.rows, 0.0f);
-		result.size = Size(image.cols + static_cast<int>(ceil(abs(alpha*image.rows))), image.rows);
-
-        result.transform = Mat(2,3, CV_32F);
-        result.transform.at<float>(0,0) = 1;
-        result.transform.at<float>(0,1) = alpha;
-        result.transform.at<float>(0,2) = shiftX;
-        result.transform.at<float>(1,0) = 0;
-        result.transform.at<float>(1,1) = 1;
-        result.transform.at<float>(1,2) = 0;
-
-        Mat imgSheared;
-		warpAffine(image, imgSheared, result.transform, result.size, INTER_NEAREST);
-
-		for (int x=0; x<imgSheared.cols; ++x){
-			vector<int> fgIndices;
-
-			for (int y=0; y<imgSheared.rows; ++y){
-				if (imgSheared.at<unsigned char>(y,x))
-					fgIndices.push_back(y);
-			}
-			if (fgIndices.empty()) continue;
-
-			int hAlpha = static_cast<int>(fgIndices.size());
-			int deltaYAlpha = fgIndices.back() - fgIndices.front() + 1;
-
-			if (hAlpha == deltaYAlpha)
-                result.sumAlpha += hAlpha*hAlpha;
-			results.push_back(result);
-		}
-
-		Result bestResult = *max_element(results.begin(), results.end());
-		warpAffine(image, output, bestResult.transform, bestResult.size, INTER_LINEAR, BORDER_CONSTANT, Scalar(bgcolor));
-    }
-}
-
 Chunk::Chunk(int i, int c, int w, Mat m): valleys(vector<Valley *>()), peaks(vector<Peak>()) {
     this->index = i;
     this->startCol = c;
     this->width = w;
-    this->img = m.clone();
+    // view on the binary image of the LineSegmentation, which is only read
+    this->img = m;
     this->histogram.resize((unsigned long) this->img.rows);
     this->avgHeight = 0;
     this->avgWhiteHeight = 0;
@@ -496,14 +457,14 @@ int Chunk::findPeaksValleys(map<int, Valley *> &mapValley) {
             }
         }
 
-        auto *newValley = new Valley(this->index, minPosition);
+        auto *newValley = new Valley(this->index, minPosition, (int) mapValley.size());
         valleys.push_back(newValley);
         mapValley[newValley->valleyID] = newValley;
     }
     return int(ceil(avgHeight));
 }
 
-Line::Line(int initialValleyID): minRowPosition(0), maxRowPosition(0), points(vector<Point>()) {
+Line::Line(int initialValleyID): above(nullptr), below(nullptr), minRowPosition(0), maxRowPosition(0), points(vector<Point>()) {
     valleysID.push_back(initialValleyID);
 }
 
@@ -653,8 +614,6 @@ bool Peak::comp(const Peak &a, const Peak &b) {
     return a.position < b.position;
 }
 
-int Valley::ID = 0;
-
 bool Valley::comp(const Valley *a, const Valley *b) {
     return a->position < b->position;
 }
@@ -1,7 +1,11 @@
 #include <iostream>
 #include <map>
+#include <set>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui/highgui.hpp>
+#include "RectMerge.hpp"
+#include "BoxGrid.hpp"
+#include "DeslantImgCPU.hpp"
 
 typedef int valleyID;
 
@@ -45,10 +49,10 @@ class Peak {
 
 class Valley {
     public:
-        Valley(): valleyID(ID++), used(false){}
-        Valley(int cID, int p): chunkIndex(cID), valleyID(ID++), position(p), used(false){}
+        // the id is unique within the LineSegmentation, which numbers its valleys itself so that
+        // pages can be segmented on several threads
+        Valley(int cID, int p, int id): chunkIndex(cID), valleyID(id), position(p), used(false){}
 
-        static int ID;
         int chunkIndex;
         int valleyID;
         int position;
@@ -101,24 +105,38 @@ class Chunk {
         void calculateHistogram();
 };
 
+// what segment() does with the line images after cutting them out
+enum DeslantMode {
+    DESLANT_NONE = 0,   // keep them as they are
+    DESLANT_IMAGE = 1,  // deslant them
+    DESLANT_ALPHA = 2   // keep them, only compute their shear value
+};
+
 class LineSegmentation {
     public:
         LineSegmentation();
+        ~LineSegmentation();
 
         Mat binaryImg;
         vector<Rect> contours;
+        BoxGrid contoursGrid;
         Mat contoursDrawing;
         Mat linesDrawing;
+        // draw the contours and the lines on the input, skipped when false
+        bool overview;
+
+        // shear value of each line image, filled unless deslanting is DESLANT_NONE
+        vector<float> alphas;
 
-        void segment(Mat &input, vector<Mat> &output, int chunksNumber, int chunksProcess);
+        void segment(Mat &input, vector<Mat> &output, int chunksNumber, int chunksProcess, bool overview = true, int deslanting = DESLANT_IMAGE);
         void getContours();
         void generateChunks();
         void getInitialLines();
         void getRegions(vector<Mat> &output);
 
         void generateRegions();
+        void deleteRegions();
         void repairLines();
-        void deslant(Mat image, Mat &output, int bgcolor);
 
     //private:
         string srcBase;
@@ -127,8 +145,8 @@ class LineSegmentation {
         int chunksNumber;
         int chunksToProcess;
 
-        bool notPrimesArr[100007];
-        vector<int> primes;
+        // the primes below 1e5, shared by all instances
+        static const vector<int> primes;
 
         int chunkWidth;
         vector<Chunk *> chunks;
@@ -138,7 +156,7 @@ class LineSegmentation {
         int avgLineHeight;
         int predictedLineHeight;
 
-        void sieve();
+        static vector<int> sieve();
         void addPrimesToVector(int, vector<int> &);
         void printLines(Mat &inputOutput);
 
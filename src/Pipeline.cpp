@@ -0,0 +1,101 @@
+#include "Pipeline.hpp"
+#include "Scanner.hpp"
+#include "Binarization.hpp"
+#include "LineSegmentation.hpp"
+#include "WordSegmentation.hpp"
+
+Pipeline::Pipeline() {
+    this->crop = true;
+    this->precheck = false;
+    this->width = 1280;
+    this->light = true;
+    this->option = BINARIZE_SAUVOLA;
+    this->lightScale = 1.0;
+    this->tileRows = 0;
+    this->chunksNumber = 8;
+    this->chunksProcess = 4;
+    this->words = true;
+    this->kernelSize = 11;
+    this->sigmas = vector<int>(1, 11);
+    this->theta = 7;
+    this->deslant = DESLANT_NONE;
+    this->keep = false;
+}
+
+void Pipeline::process(Mat image, PageResult &result) {
+    // crop and resize in one resampling of the input
+    Mat page;
+    Mat transform = Mat::eye(3, 3, CV_64F);
+    Size from = image.size();
+    result.cropped = false;
+    if (this->crop) {
+        Scanner scanner;
+        scanner.precheck = this->precheck;
+        scanner.locate(image);
+        scanner.warp(image, page, this->width);
+        result.cropped = scanner.cropped;
+        scanner.transform.copyTo(transform);
+        from = scanner.cropSize;
+    } else if (this->width > 0 && this->width != image.cols) {
+        resize(image, page, Size(this->width, (this->width * image.rows) / image.cols));
+    } else {
+        page = image;
+    }
+    Mat scaling = Mat::eye(3, 3, CV_64F);
+    scaling.at<double>(0, 0) = (double) page.cols / max(from.width, 1);
+    scaling.at<double>(1, 1) = (double) page.rows / max(from.height, 1);
+    result.transform = scaling * transform;
+    result.size = page.size();
+
+    Binarization threshold;
+    threshold.tileRows = this->tileRows;
+    Mat binary;
+    threshold.binarize(page, binary, this->light, this->option, this->lightScale);
+
+    // the paths between the text lines, as (x, y) instead of the (row, col) of LineSegmentation
+    LineSegmentation line;
+    vector<Mat> regions;
+    line.segment(binary, regions, this->chunksNumber, this->chunksProcess, false, DESLANT_NONE);
+    regions.clear();
+    result.paths.clear();
+    for (unsigned int i=1; i<line.lineRegions.size(); i++) {
+        vector<Point> path;
+        for (auto point : line.lineRegions[i]->top->points)
+            path.push_back(Point(point.y, point.x));
+        result.paths.push_back(path);
+    }
+
+    WordSegmentation word;
+    if (this->words) {
+        if (this->sigmas.size() == 1)
+            word.setKernel(this->kernelSize, this->sigmas[0], this->theta);
+        else
+            word.setScales(this->sigmas, this->theta);
+    }
+    vector<Mat> lines;
+    word.segmentPage(binary, result.paths, lines, result.lineRects, result.words, result.sigmas);
+
+    // the word images are cut before the lines are deslanted
+    result.wordImages.clear();
+    if (this->keep) {
+        result.wordImages.resize(lines.size());
+        for (unsigned int i=0; i<lines.size(); i++) {
+            for (auto box : result.words[i])
+                result.wordImages[i].push_back(lines[i](box - result.lineRects[i].tl()));
+        }
+    }
+
+    result.alphas.clear();
+    if (this->deslant != DESLANT_NONE)
+        htr::deslantImgs(lines, result.alphas, this->deslant == DESLANT_IMAGE, 255);
+
+    if (this->keep) {
+        result.page = page;
+        result.binary = binary;
+        result.lines = lines;
+    } else {
+        result.page.release();
+        result.binary.release();
+        result.lines.clear();
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include <opencv2/imgproc/imgproc.hpp>
+
+using namespace cv;
+using namespace std;
+
+// Everything the pipeline finds on a page. Coordinates are those of the page after cropping and resizing.
+struct PageResult {
+    // a crop was found, transform maps the pixel coordinates (x, y, 1) of the input to those of the page
+    bool cropped;
+    Mat transform;
+    Size size;
+    // the paths between the text lines, the bounding box of each text line and its word boxes
+    vector<vector<Point>> paths;
+    vector<Rect> lineRects;
+    vector<vector<Rect>> words;
+    // the sigma of the word segmentation kernel used for each text line
+    vector<int> sigmas;
+    // shear value of each text line, empty when not deslanting
+    vector<float> alphas;
+
+    // only filled when keeping the images: the page, its binary image, the text lines (white outside
+    // of their area, deslanted if asked) and the words cut from the binary text lines
+    Mat page;
+    Mat binary;
+    vector<Mat> lines;
+    vector<vector<Mat>> wordImages;
+};
+
+// Crop, resize, binarize and segment a page into text lines and words at once, keeping the
+// intermediate images in native memory. Set the options before calling process.
+class Pipeline {
+    public:
+        Pipeline();
+        void process(Mat image, PageResult &result);
+
+        // crop the page (see Scanner), precheck skips the search if the page is already tight
+        bool crop;
+        bool precheck;
+        // resample the (cropped) page to this width at once, 0 keeps the width
+        int width;
+        // binarisation (see Binarization::binarize), option is a BinarizationMethod
+        bool light;
+        int option;
+        double lightScale;
+        int tileRows;
+        // line segmentation
+        int chunksNumber;
+        int chunksProcess;
+        // word segmentation, with several sigmas the sigma of each line is picked (see WordSegmentation::setScales)
+        bool words;
+        int kernelSize;
+        vector<int> sigmas;
+        int theta;
+        // DeslantMode of the text lines
+        int deslant;
+        // keep the images in the result
+        bool keep;
+};
@@ -89,8 +89,8 @@ BEGIN_RCPP
 END_RCPP
 }
 // textlinedetector_deslant
-XPtrMat textlinedetector_deslant(XPtrMat ptr, const int bgcolor, const float lower_bound, const float upper_bound);
-RcppExport SEXP _image_textlinedetector_textlinedetector_deslant(SEXP ptrSEXP, SEXP bgcolorSEXP, SEXP lower_boundSEXP, SEXP upper_boundSEXP) {
+XPtrMat textlinedetector_deslant(XPtrMat ptr, const int bgcolor, const float lower_bound, const float upper_bound, const float precision);
+RcppExport SEXP _image_textlinedetector_textlinedetector_deslant(SEXP ptrSEXP, SEXP bgcolorSEXP, SEXP lower_boundSEXP, SEXP upper_boundSEXP, SEXP precisionSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -98,13 +98,29 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const int >::type bgcolor(bgcolorSEXP);
     Rcpp::traits::input_parameter< const float >::type lower_bound(lower_boundSEXP);
     Rcpp::traits::input_parameter< const float >::type upper_bound(upper_boundSEXP);
-    rcpp_result_gen = Rcpp::wrap(textlinedetector_deslant(ptr, bgcolor, lower_bound, upper_bound));
+    Rcpp::traits::input_parameter< const float >::type precision(precisionSEXP);
+    rcpp_result_gen = Rcpp::wrap(textlinedetector_deslant(ptr, bgcolor, lower_bound, upper_bound, precision));
+    return rcpp_result_gen;
+END_RCPP
+}
+// textlinedetector_deslant_list
+Rcpp::List textlinedetector_deslant_list(Rcpp::List ptrs, const int bgcolor, const float lower_bound, const float upper_bound, const float precision);
+RcppExport SEXP _image_textlinedetector_textlinedetector_deslant_list(SEXP ptrsSEXP, SEXP bgcolorSEXP, SEXP lower_boundSEXP, SEXP upper_boundSEXP, SEXP precisionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::List >::type ptrs(ptrsSEXP);
+    Rcpp::traits::input_parameter< const int >::type bgcolor(bgcolorSEXP);
+    Rcpp::traits::input_parameter< const float >::type lower_bound(lower_boundSEXP);
+    Rcpp::traits::input_parameter< const float >::type upper_bound(upper_boundSEXP);
+    Rcpp::traits::input_parameter< const float >::type precision(precisionSEXP);
+    rcpp_result_gen = Rcpp::wrap(textlinedetector_deslant_list(ptrs, bgcolor, lower_bound, upper_bound, precision));
     return rcpp_result_gen;
 END_RCPP
 }
 // textlinedetector_astarpath
-Rcpp::List textlinedetector_astarpath(XPtrMat ptr, bool morph, int step, int mfactor, bool trace);
-RcppExport SEXP _image_textlinedetector_textlinedetector_astarpath(SEXP ptrSEXP, SEXP morphSEXP, SEXP stepSEXP, SEXP mfactorSEXP, SEXP traceSEXP) {
+Rcpp::List textlinedetector_astarpath(XPtrMat ptr, bool morph, int step, int mfactor, bool trace, bool overview);
+RcppExport SEXP _image_textlinedetector_textlinedetector_astarpath(SEXP ptrSEXP, SEXP morphSEXP, SEXP stepSEXP, SEXP mfactorSEXP, SEXP traceSEXP, SEXP overviewSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -113,18 +129,34 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type step(stepSEXP);
     Rcpp::traits::input_parameter< int >::type mfactor(mfactorSEXP);
     Rcpp::traits::input_parameter< bool >::type trace(traceSEXP);
-    rcpp_result_gen = Rcpp::wrap(textlinedetector_astarpath(ptr, morph, step, mfactor, trace));
+    Rcpp::traits::input_parameter< bool >::type overview(overviewSEXP);
+    rcpp_result_gen = Rcpp::wrap(textlinedetector_astarpath(ptr, morph, step, mfactor, trace, overview));
     return rcpp_result_gen;
 END_RCPP
 }
 // textlinedetector_crop
-XPtrMat textlinedetector_crop(XPtrMat ptr);
-RcppExport SEXP _image_textlinedetector_textlinedetector_crop(SEXP ptrSEXP) {
+XPtrMat textlinedetector_crop(XPtrMat ptr, int width, int height, bool precheck);
+RcppExport SEXP _image_textlinedetector_textlinedetector_crop(SEXP ptrSEXP, SEXP widthSEXP, SEXP heightSEXP, SEXP precheckSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< XPtrMat >::type ptr(ptrSEXP);
+    Rcpp::traits::input_parameter< int >::type width(widthSEXP);
+    Rcpp::traits::input_parameter< int >::type height(heightSEXP);
+    Rcpp::traits::input_parameter< bool >::type precheck(precheckSEXP);
+    rcpp_result_gen = Rcpp::wrap(textlinedetector_crop(ptr, width, height, precheck));
+    return rcpp_result_gen;
+END_RCPP
+}
+// textlinedetector_crop_transform
+Rcpp::List textlinedetector_crop_transform(XPtrMat ptr, bool precheck);
+RcppExport SEXP _image_textlinedetector_textlinedetector_crop_transform(SEXP ptrSEXP, SEXP precheckSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< XPtrMat >::type ptr(ptrSEXP);
-    rcpp_result_gen = Rcpp::wrap(textlinedetector_crop(ptr));
+    Rcpp::traits::input_parameter< bool >::type precheck(precheckSEXP);
+    rcpp_result_gen = Rcpp::wrap(textlinedetector_crop_transform(ptr, precheck));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -141,21 +173,23 @@ BEGIN_RCPP
 END_RCPP
 }
 // textlinedetector_binarization
-XPtrMat textlinedetector_binarization(XPtrMat ptr, bool light, int type);
-RcppExport SEXP _image_textlinedetector_textlinedetector_binarization(SEXP ptrSEXP, SEXP lightSEXP, SEXP typeSEXP) {
+XPtrMat textlinedetector_binarization(XPtrMat ptr, bool light, int type, double lightScale, int tileRows);
+RcppExport SEXP _image_textlinedetector_textlinedetector_binarization(SEXP ptrSEXP, SEXP lightSEXP, SEXP typeSEXP, SEXP lightScaleSEXP, SEXP tileRowsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< XPtrMat >::type ptr(ptrSEXP);
     Rcpp::traits::input_parameter< bool >::type light(lightSEXP);
     Rcpp::traits::input_parameter< int >::type type(typeSEXP);
-    rcpp_result_gen = Rcpp::wrap(textlinedetector_binarization(ptr, light, type));
+    Rcpp::traits::input_parameter< double >::type lightScale(lightScaleSEXP);
+    Rcpp::traits::input_parameter< int >::type tileRows(tileRowsSEXP);
+    rcpp_result_gen = Rcpp::wrap(textlinedetector_binarization(ptr, light, type, lightScale, tileRows));
     return rcpp_result_gen;
 END_RCPP
 }
 // textlinedetector_linesegmentation
-Rcpp::List textlinedetector_linesegmentation(XPtrMat ptr, int chunksNumber, int chunksProcess, int kernelSize, int sigma, int theta);
-RcppExport SEXP _image_textlinedetector_textlinedetector_linesegmentation(SEXP ptrSEXP, SEXP chunksNumberSEXP, SEXP chunksProcessSEXP, SEXP kernelSizeSEXP, SEXP sigmaSEXP, SEXP thetaSEXP) {
+Rcpp::List textlinedetector_linesegmentation(XPtrMat ptr, int chunksNumber, int chunksProcess, int kernelSize, int sigma, int theta, bool overview, int deslant);
+RcppExport SEXP _image_textlinedetector_textlinedetector_linesegmentation(SEXP ptrSEXP, SEXP chunksNumberSEXP, SEXP chunksProcessSEXP, SEXP kernelSizeSEXP, SEXP sigmaSEXP, SEXP thetaSEXP, SEXP overviewSEXP, SEXP deslantSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -165,13 +199,15 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type kernelSize(kernelSizeSEXP);
     Rcpp::traits::input_parameter< int >::type sigma(sigmaSEXP);
     Rcpp::traits::input_parameter< int >::type theta(thetaSEXP);
-    rcpp_result_gen = Rcpp::wrap(textlinedetector_linesegmentation(ptr, chunksNumber, chunksProcess, kernelSize, sigma, theta));
+    Rcpp::traits::input_parameter< bool >::type overview(overviewSEXP);
+    Rcpp::traits::input_parameter< int >::type deslant(deslantSEXP);
+    rcpp_result_gen = Rcpp::wrap(textlinedetector_linesegmentation(ptr, chunksNumber, chunksProcess, kernelSize, sigma, theta, overview, deslant));
     return rcpp_result_gen;
 END_RCPP
 }
 // textlinedetector_wordsegmentation
-Rcpp::List textlinedetector_wordsegmentation(XPtrMat ptr, int kernelSize, int sigma, int theta);
-RcppExport SEXP _image_textlinedetector_textlinedetector_wordsegmentation(SEXP ptrSEXP, SEXP kernelSizeSEXP, SEXP sigmaSEXP, SEXP thetaSEXP) {
+Rcpp::List textlinedetector_wordsegmentation(XPtrMat ptr, int kernelSize, int sigma, int theta, bool overview);
+RcppExport SEXP _image_textlinedetector_textlinedetector_wordsegmentation(SEXP ptrSEXP, SEXP kernelSizeSEXP, SEXP sigmaSEXP, SEXP thetaSEXP, SEXP overviewSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -179,7 +215,49 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type kernelSize(kernelSizeSEXP);
     Rcpp::traits::input_parameter< int >::type sigma(sigmaSEXP);
     Rcpp::traits::input_parameter< int >::type theta(thetaSEXP);
-    rcpp_result_gen = Rcpp::wrap(textlinedetector_wordsegmentation(ptr, kernelSize, sigma, theta));
+    Rcpp::traits::input_parameter< bool >::type overview(overviewSEXP);
+    rcpp_result_gen = Rcpp::wrap(textlinedetector_wordsegmentation(ptr, kernelSize, sigma, theta, overview));
+    return rcpp_result_gen;
+END_RCPP
+}
+// textlinedetector_wordsegmentation_page
+Rcpp::List textlinedetector_wordsegmentation_page(XPtrMat ptr, Rcpp::List paths, std::vector<int> sigma, int kernelSize, int theta, bool crops);
+RcppExport SEXP _image_textlinedetector_textlinedetector_wordsegmentation_page(SEXP ptrSEXP, SEXP pathsSEXP, SEXP sigmaSEXP, SEXP kernelSizeSEXP, SEXP thetaSEXP, SEXP cropsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< XPtrMat >::type ptr(ptrSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type paths(pathsSEXP);
+    Rcpp::traits::input_parameter< std::vector<int> >::type sigma(sigmaSEXP);
+    Rcpp::traits::input_parameter< int >::type kernelSize(kernelSizeSEXP);
+    Rcpp::traits::input_parameter< int >::type theta(thetaSEXP);
+    Rcpp::traits::input_parameter< bool >::type crops(cropsSEXP);
+    rcpp_result_gen = Rcpp::wrap(textlinedetector_wordsegmentation_page(ptr, paths, sigma, kernelSize, theta, crops));
+    return rcpp_result_gen;
+END_RCPP
+}
+// textlinedetector_pipeline
+Rcpp::List textlinedetector_pipeline(XPtrMat ptr, Rcpp::List options);
+RcppExport SEXP _image_textlinedetector_textlinedetector_pipeline(SEXP ptrSEXP, SEXP optionsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< XPtrMat >::type ptr(ptrSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type options(optionsSEXP);
+    rcpp_result_gen = Rcpp::wrap(textlinedetector_pipeline(ptr, options));
+    return rcpp_result_gen;
+END_RCPP
+}
+// textlinedetector_pipeline_batch
+Rcpp::List textlinedetector_pipeline_batch(Rcpp::List pages, Rcpp::List options, int threads);
+RcppExport SEXP _image_textlinedetector_textlinedetector_pipeline_batch(SEXP pagesSEXP, SEXP optionsSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::List >::type pages(pagesSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type options(optionsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(textlinedetector_pipeline_batch(pages, options, threads));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -202,13 +280,18 @@ static const R_CallMethodDef CallEntries[] = {
     {"_image_textlinedetector_cvmat_polygon", (DL_FUNC) &_image_textlinedetector_cvmat_polygon, 5},
     {"_image_textlinedetector_cvmat_bitmap", (DL_FUNC) &_image_textlinedetector_cvmat_bitmap, 1},
     {"_image_textlinedetector_cvmat_info", (DL_FUNC) &_image_textlinedetector_cvmat_info, 1},
-    {"_image_textlinedetector_textlinedetector_deslant", (DL_FUNC) &_image_textlinedetector_textlinedetector_deslant, 4},
-    {"_image_textlinedetector_textlinedetector_astarpath", (DL_FUNC) &_image_textlinedetector_textlinedetector_astarpath, 5},
-    {"_image_textlinedetector_textlinedetector_crop", (DL_FUNC) &_image_textlinedetector_textlinedetector_crop, 1},
+    {"_image_textlinedetector_textlinedetector_deslant", (DL_FUNC) &_image_textlinedetector_textlinedetector_deslant, 5},
+    {"_image_textlinedetector_textlinedetector_deslant_list", (DL_FUNC) &_image_textlinedetector_textlinedetector_deslant_list, 5},
+    {"_image_textlinedetector_textlinedetector_astarpath", (DL_FUNC) &_image_textlinedetector_textlinedetector_astarpath, 6},
+    {"_image_textlinedetector_textlinedetector_crop", (DL_FUNC) &_image_textlinedetector_textlinedetector_crop, 4},
+    {"_image_textlinedetector_textlinedetector_crop_transform", (DL_FUNC) &_image_textlinedetector_textlinedetector_crop_transform, 2},
     {"_image_textlinedetector_textlinedetector_resize", (DL_FUNC) &_image_textlinedetector_textlinedetector_resize, 2},
-    {"_image_textlinedetector_textlinedetector_binarization", (DL_FUNC) &_image_textlinedetector_textlinedetector_binarization, 3},
-    {"_image_textlinedetector_textlinedetector_linesegmentation", (DL_FUNC) &_image_textlinedetector_textlinedetector_linesegmentation, 6},
-    {"_image_textlinedetector_textlinedetector_wordsegmentation", (DL_FUNC) &_image_textlinedetector_textlinedetector_wordsegmentation, 4},
+    {"_image_textlinedetector_textlinedetector_binarization", (DL_FUNC) &_image_textlinedetector_textlinedetector_binarization, 5},
+    {"_image_textlinedetector_textlinedetector_linesegmentation", (DL_FUNC) &_image_textlinedetector_textlinedetector_linesegmentation, 8},
+    {"_image_textlinedetector_textlinedetector_wordsegmentation", (DL_FUNC) &_image_textlinedetector_textlinedetector_wordsegmentation, 5},
+    {"_image_textlinedetector_textlinedetector_wordsegmentation_page", (DL_FUNC) &_image_textlinedetector_textlinedetector_wordsegmentation_page, 6},
+    {"_image_textlinedetector_textlinedetector_pipeline", (DL_FUNC) &_image_textlinedetector_textlinedetector_pipeline, 2},
+    {"_image_textlinedetector_textlinedetector_pipeline_batch", (DL_FUNC) &_image_textlinedetector_textlinedetector_pipeline_batch, 3},
     {"_image_textlinedetector_sieve", (DL_FUNC) &_image_textlinedetector_sieve, 1},
     {NULL, NULL, 0}
 };
@@ -0,0 +1,98 @@
+#include "RectMerge.hpp"
+#include <numeric>
+
+class DisjointSet {
+    public:
+        DisjointSet(int n): parent(n) {
+            iota(parent.begin(), parent.end(), 0);
+        }
+
+        int find(int i) {
+            while (parent[i] != i)
+                i = parent[i] = parent[parent[i]];
+            return i;
+        }
+
+        void unite(int a, int b) {
+            a = find(a);
+            b = find(b);
+            if (a != b) parent[max(a, b)] = min(a, b);
+        }
+
+    private:
+        vector<int> parent;
+};
+
+static bool isNested(const Rect &a, const Rect &b) {
+    int area = (a & b).area();
+    return area == a.area() || area == b.area();
+}
+
+// Sweep over the rectangles sorted by x, only testing pairs that overlap horizontally
+// (after widening by `reach`), and union the related ones.
+template<typename Related>
+static vector<Rect> groupRects(const vector<Rect> &rects, int reach, Related related) {
+    vector<int> order(rects.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&rects](int a, int b){ return rects[a].x < rects[b].x; });
+
+    DisjointSet sets((int) rects.size());
+    vector<int> active;
+
+    for (int i : order) {
+        const Rect &r = rects[i];
+        size_t kept = 0;
+
+        for (size_t k=0; k<active.size(); k++) {
+            const Rect &a = rects[active[k]];
+            if (a.x + a.width + reach <= r.x) continue;
+
+            active[kept++] = active[k];
+            if (related(a, r)) sets.unite(active[k], i);
+        }
+        active.resize(kept);
+        active.push_back(i);
+    }
+
+    vector<int> slot(rects.size(), -1);
+    vector<Rect> merged;
+
+    for (int i : order) {
+        int root = sets.find(i);
+        if (slot[root] < 0) {
+            slot[root] = (int) merged.size();
+            merged.push_back(rects[i]);
+        } else {
+            merged[slot[root]] |= rects[i];
+        }
+    }
+    return merged;
+}
+
+// Regroup until no more rectangles merge, as a union can relate to rectangles its parts did not.
+template<typename Related>
+static vector<Rect> mergeUntilStable(vector<Rect> rects, int reach, Related related) {
+    while (true) {
+        vector<Rect> merged = groupRects(rects, reach, related);
+        if (merged.size() == rects.size()) return merged;
+        rects.swap(merged);
+    }
+}
+
+vector<Rect> mergeNestedRects(vector<Rect> rects) {
+    return mergeUntilStable(rects, 0, isNested);
+}
+
+vector<Rect> mergeCloseRects(vector<Rect> rects, int gap) {
+    return mergeUntilStable(rects, gap, [gap](const Rect &a, const Rect &b){
+        return a.x < b.x + b.width + gap && b.x < a.x + a.width + gap &&
+               a.y < b.y + b.height + gap && b.y < a.y + a.height + gap;
+    });
+}
+
+vector<Rect> mergeStackedRects(vector<Rect> rects) {
+    return mergeUntilStable(rects, 0, [](const Rect &a, const Rect &b){
+        return (a.x <= b.x && a.x + a.width >= b.x + b.width) ||
+               (b.x <= a.x && b.x + b.width >= a.x + a.width);
+    });
+}
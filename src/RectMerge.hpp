@@ -0,0 +1,18 @@
+#pragma once
+#include <vector>
+#include <opencv2/imgproc/imgproc.hpp>
+
+using namespace cv;
+using namespace std;
+
+// Replaces every group of (transitively) nested rectangles by their union.
+// The result is ordered by x.
+vector<Rect> mergeNestedRects(vector<Rect> rects);
+
+// Replaces every group of rectangles which (transitively) overlap or lie less than `gap`
+// pixels apart by their union. The result is ordered by x.
+vector<Rect> mergeCloseRects(vector<Rect> rects, int gap);
+
+// Replaces every group of rectangles of which the horizontal extent of one (transitively)
+// contains the other by their union. The result is ordered by x.
+vector<Rect> mergeStackedRects(vector<Rect> rects);
@@ -2,12 +2,8 @@
 
 Scanner::Scanner() {
 	this->cropped = false;
-}
-
-bool compareContourAreas(vector<Point> contour1, vector<Point> contour2){
-	double i = fabs(contourArea(Mat(contour1)));
-	double j = fabs(contourArea(Mat(contour2)));
-	return (i > j);
+	this->precheck = false;
+	this->rectangular = true;
 }
 
 bool compareXCords(Point p1, Point p2){
@@ -55,7 +51,7 @@ void Scanner::orderPoints(vector<Point> inpts, vector<Point> &ordered){
 	ordered.push_back(bl);
 }
 
-void Scanner::fourPointTransform(Mat src, Mat &dst, vector<Point> pts){
+void Scanner::fourPointTransform(vector<Point> pts){
 	vector<Point> orderedPts;
 	orderPoints(pts, orderedPts);
 
@@ -81,13 +77,58 @@ void Scanner::fourPointTransform(Mat src, Mat &dst, vector<Point> pts){
         Point2f(0, mh-1)
 	};
 
-	Mat m = getPerspectiveTransform(src_, dst_);
-	warpPerspective(src, dst, m, Size(mw, mh), BORDER_REPLICATE, INTER_LINEAR);
+	this->transform = getPerspectiveTransform(src_, dst_);
+	this->cropSize = Size((int) mw, (int) mh);
+	this->rectangular = false;
+}
+
+void Scanner::rectTransform(Rect roi){
+	this->transform = Mat::eye(3, 3, CV_64F);
+	this->transform.at<double>(0, 2) = -roi.x;
+	this->transform.at<double>(1, 2) = -roi.y;
+	this->cropSize = roi.size();
+	this->rectangular = true;
+}
+
+void Scanner::process(Mat image, Mat &output){
+	locate(image);
+	warp(image, output);
+}
+
+void Scanner::warp(Mat image, Mat &output, int width, int height){
+	Size size = this->cropSize;
+	if (width > 0 && height > 0){
+		size = Size(width, height);
+	} else if (width > 0){
+		size = Size(width, max(1, cvRound(this->cropSize.height * (width / double(this->cropSize.width)))));
+	} else if (height > 0){
+		size = Size(max(1, cvRound(this->cropSize.width * (height / double(this->cropSize.height)))), height);
+	}
+
+	if (this->rectangular){
+		Rect roi(cvRound(-this->transform.at<double>(0, 2)), cvRound(-this->transform.at<double>(1, 2)), this->cropSize.width, this->cropSize.height);
+		if (size == this->cropSize && roi == Rect(0, 0, image.cols, image.rows))
+			output = image;
+		else if (size == this->cropSize)
+			image(roi).copyTo(output);
+		else
+			resize(image(roi), output, size, 0, 0, INTER_AREA);
+		return;
+	}
+
+	// scale the homography to the requested size, so the image is resampled once
+	Mat scale = Mat::eye(3, 3, CV_64F);
+	scale.at<double>(0, 0) = size.width / double(this->cropSize.width);
+	scale.at<double>(1, 1) = size.height / double(this->cropSize.height);
+	warpPerspective(image, output, scale * this->transform, size, INTER_LINEAR, BORDER_REPLICATE);
 }
 
 void Scanner::processEdge(Mat input, Mat &output, int openKSize, int closeKSize, bool gaussianBlur){
     Mat image_pp, structuringElmt;
-	cvtColor(input, image_pp, COLOR_BGR2GRAY);
+	if (input.channels() == 1)
+		image_pp = input.clone();
+	else
+		cvtColor(input, image_pp, COLOR_BGR2GRAY);
 
 	if (openKSize > 0){
 		structuringElmt = getStructuringElement(MORPH_ELLIPSE, Size(openKSize,openKSize));
@@ -104,86 +145,112 @@ void Scanner::processEdge(Mat input, Mat &output, int openKSize, int closeKSize,
 	Canny(image_pp, output, 50, 60, 3, true);
 }
 
-void Scanner::process(Mat image, Mat &output){
-	Mat orig = image.clone();
+bool Scanner::isTight(Mat image){
+	Mat thumb, ink;
+	resizeToHeight(image, thumb, min(image.rows, 128));
+	if (thumb.channels() == 3)
+		cvtColor(thumb, thumb, COLOR_BGR2GRAY);
+	else if (thumb.channels() == 4)
+		cvtColor(thumb, thumb, COLOR_BGRA2GRAY);
+	threshold(thumb, ink, 0, 255, THRESH_BINARY_INV | THRESH_OTSU);
+
+	// border strips of 3% of the size, at least 1 pixel
+	int bx = max(1, cvRound(ink.cols * 0.03));
+	int by = max(1, cvRound(ink.rows * 0.03));
+	Rect borders[] = {
+		Rect(0, 0, ink.cols, by),
+		Rect(0, ink.rows - by, ink.cols, by),
+		Rect(0, 0, bx, ink.rows),
+		Rect(ink.cols - bx, 0, bx, ink.rows)
+	};
+
+	for (unsigned int i=0; i<4; i++){
+		double density = countNonZero(ink(borders[i])) / (double) borders[i].area();
+		if (density == 0 || density > 0.5)
+			return false;
+	}
+	return true;
+}
+
+void Scanner::locate(Mat image){
+	Mat orig = image;
+	this->cropped = false;
+
+	if (this->precheck && isTight(image)){
+		rectTransform(Rect(0, 0, image.cols, image.rows));
+		return;
+	}
 
 	double ratio = image.rows / 500.0;
 	resizeToHeight(image, image, 500);
 
-	Mat edged, edgedCache;
+	Mat edged;
 	processEdge(image, edged, 11, 11, true);
-	edgedCache = edged.clone();
 
-	vector<vector<Point>> contours, shapes;
+	vector<vector<Point>> contours;
 	vector<Vec4i> hierarchy;
 	
 	findContours(edged, contours, hierarchy, RETR_LIST, CHAIN_APPROX_SIMPLE);
 	edged = Mat::zeros(Size(image.cols, image.rows), CV_8UC1);
 
-	vector<vector<Point>> hull(contours.size());
-	int sum_area = 0, mean_area = 0;
+	if (!contours.empty()){
+		// the convex hull of all hulls with at least the mean area, their order does not matter
+		vector<vector<Point>> hull(contours.size());
+		vector<double> areas(contours.size());
+		int sum_area = 0, mean_area = 0;
 
-	for(unsigned int i=0; i<contours.size(); i++){
-		convexHull(Mat(contours[i]), hull[i], false);
-		sum_area += contourArea(Mat(hull[i]));
-	}
-	mean_area = sum_area / hull.size();
-
-	for(unsigned int i=0; i<hull.size(); i++){
-		if(contourArea(Mat(hull[i])) >= mean_area){
-			shapes.push_back(hull[i]);
+		for(unsigned int i=0; i<contours.size(); i++){
+			convexHull(contours[i], hull[i], false);
+			areas[i] = contourArea(hull[i]);
+			sum_area += areas[i];
 		}
-	}
-	sort(shapes.begin(), shapes.end(), compareContourAreas);	
-
-	for(unsigned int i=1; i<shapes.size(); i++){
-		for(unsigned int j=0; j<shapes[i].size(); j++)
-			shapes[0].push_back(shapes[i][j]);
-	}
+		mean_area = sum_area / (int) hull.size();
 
-	convexHull(Mat(shapes[0]), hull[0], false);
-	drawContours(edged, hull, 0, 255, 2);
-	findContours(edged, contours, hierarchy, RETR_LIST, CHAIN_APPROX_SIMPLE);
+		vector<Point> shape;
+		for(unsigned int i=0; i<hull.size(); i++){
+			if(areas[i] >= mean_area)
+				shape.insert(shape.end(), hull[i].begin(), hull[i].end());
+		}
 
-	vector<vector<Point>> approx;
-	approx.resize(contours.size());
+		if (!shape.empty()){
+			convexHull(shape, hull[0], false);
+			drawContours(edged, hull, 0, 255, 2);
+			findContours(edged, contours, hierarchy, RETR_LIST, CHAIN_APPROX_SIMPLE);
 
-	for(unsigned int i=0; i<contours.size(); i++){
-		double peri = 0.01 * arcLength(contours[i], true);
-		approxPolyDP(contours[i], approx[i], peri, true);
-	}
+			vector<Point> approx;
+			for(unsigned int i=0; i<contours.size(); i++){
+				double peri = 0.01 * arcLength(contours[i], true);
+				approxPolyDP(contours[i], approx, peri, true);
 
-	for(unsigned int i=0; i<approx.size(); i++){
-		if(approx[i].size() == 4){
-			for(unsigned int j=0; j<approx[i].size(); j++)
-				approx[i][j] *= ratio;
+				if(approx.size() == 4){
+					for(unsigned int j=0; j<approx.size(); j++)
+						approx[j] *= ratio;
 
-			fourPointTransform(orig, output, approx[i]);
-			this->cropped = true;
-			return;
+					fourPointTransform(approx);
+					this->cropped = true;
+					return;
+				}
+			}
 		}
 	}
 
+	Mat edgedCache;
 	processEdge(image, edgedCache, 11, 9, false);
 
 	Mat kernel = getStructuringElement(MORPH_RECT, Size(21,21));
 	dilate(edgedCache, edgedCache, kernel);
 
-    normalize(edgedCache, edgedCache, 0, 255, NORM_MINMAX, CV_32F);
-
+	// bounding box of the edges, there are none if the edge image is constant
 	int minX = edgedCache.cols, minY = edgedCache.rows;
 	int maxX = 0, maxY = 1;
 
-	for (int i=0; i<edgedCache.rows; i++){
-		for (int j=0; j<edgedCache.cols; j++){
-			if (edgedCache.at<float>(i,j) > 0){
-				minX = j < minX ? j : minX;
-				minY = i < minY ? i : minY;
-
-				maxX = j > maxX ? j : maxX;
-				maxY = i > maxY ? i : maxY;
-			}
-		}
+	int edges = countNonZero(edgedCache);
+	if (edges > 0 && edges < (int) edgedCache.total()){
+		Rect box = boundingRect(edgedCache);
+		minX = box.x;
+		minY = box.y;
+		maxX = box.x + box.width - 1;
+		maxY = max(maxY, box.y + box.height - 1);
 	}
 
 	if (maxX > minX || maxY > minY){
@@ -193,8 +260,9 @@ void Scanner::process(Mat image, Mat &output){
 		int width = maxX-minX;
 		int height = maxY-minY;
 
-		orig(Rect(minX, minY, width, height)).copyTo(output);
+		rectTransform(Rect(minX, minY, width, height));
+		this->cropped = true;
 	} else {
-		output = orig;
+		rectTransform(Rect(0, 0, orig.cols, orig.rows));
 	}
 }
@@ -9,10 +9,26 @@ class Scanner {
     public:
         Scanner();
         void process(Mat image, Mat &output);
+        // find the crop without warping the image, sets cropped, transform and cropSize
+        void locate(Mat image);
+        // warp the image with the crop found by locate, directly at width x height if given,
+        // if only one of them is given the other follows the aspect ratio of the crop
+        void warp(Mat image, Mat &output, int width = 0, int height = 0);
+        // nothing to crop: the ink on a thumbnail reaches all 4 borders without filling them (no background)
+        bool isTight(Mat image);
+
 	    bool cropped;
+        // let locate check isTight first and skip the search for a crop if so
+        bool precheck;
+        // 3x3 homography mapping the pixel coordinates of the image to the ones of the crop
+        Mat transform;
+        Size cropSize;
+        // the crop is an axis aligned rectangle of the image (a translation)
+        bool rectangular;
 
     private:
         void processEdge(Mat input, Mat &output, int openKSize, int closeKSize, bool gaussianBlur);
-        void fourPointTransform(Mat src, Mat &dst, vector<Point> pts);
+        void fourPointTransform(vector<Point> pts);
+        void rectTransform(Rect roi);
         void orderPoints(vector<Point> inpts, vector<Point> &ordered);
 };
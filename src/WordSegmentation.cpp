@@ -1,84 +1,55 @@
 #include "WordSegmentation.hpp"
+#include "RectMerge.hpp"
+#include <map>
+#include <mutex>
+#include <tuple>
 
-WordSegmentation::WordSegmentation() {}
-
-bool compareXCords(const Rect &p1, const Rect &p2){
-	return (p1.x < p2.x);
-}
-
-void WordSegmentation::printContours(Mat image, vector<vector<Point>> contours, vector<Vec4i> hierarchy, int idx){
-    for(int i = idx; i >= 0; i = hierarchy[i][0]){
-        drawContours(image, contours, i, Scalar(255));
-        for(int j=hierarchy[i][2]; j>=0; j=hierarchy[j][0])
-            printContours(image, contours, hierarchy, hierarchy[j][2]);
-    }
-}
+WordSegmentation::WordSegmentation(): kernelSigma(0), scalesTheta(0) {}
 
+// Groups the components of the filtered line into word boxes: components whose boxes overlap
+// or nearly touch are joined, then boxes stacked above each other (accents, dots) are joined.
 void WordSegmentation::processBounds(Mat &image, vector<Rect> &boundRect){
     vector<vector<Point>> contours;
-   	vector<Vec4i> hierarchy;
-    Mat edged;
-    unsigned int lastNumber = 0;
+    findContours(image, contours, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
 
-    while(true){
-        findContours(image, contours, hierarchy, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
-        edged = Mat::zeros(Size(image.cols, image.rows), CV_8UC1);
+    vector<Rect> rects;
+    rects.reserve(contours.size());
+    for (unsigned int i=0; i<contours.size(); i++)
+        rects.push_back(boundingRect(contours[i]));
 
-        for (unsigned int i=0; i<contours.size(); i++){
-            Rect r = boundingRect(Mat(contours[i]));
-            rectangle(edged, r.tl(), r.br(), 255, 2, 8, 0);
-        }
-        
-        printContours(edged, contours, hierarchy, 0);
-        image = edged;
+    boundRect = mergeStackedRects(mergeCloseRects(rects, 3));
+}
 
-        if (contours.size() == lastNumber) break;
-        lastNumber = contours.size();
-    }
+// word boxes of a line which is padded by 10 white pixels, in padded coordinates
+void WordSegmentation::locateWords(Mat padded, vector<Rect> &boundRect){
+    Mat imgFiltered, filteredX, filteredY;
+    sepFilter2D(padded, filteredX, CV_32F, this->kernelGaussY, this->kernelTermX);
+    sepFilter2D(padded, filteredY, CV_32F, this->kernelTermY, this->kernelGaussX);
+    add(filteredX, filteredY, filteredX);
+    filteredX.convertTo(imgFiltered, CV_8UC1);
+    threshold(imgFiltered, imgFiltered, 0, 255, THRESH_BINARY_INV | THRESH_OTSU);
 
-    for (unsigned int i=0; i<contours.size(); i++)
-        boundRect.push_back(boundingRect(Mat(contours[i])));
-    sort(boundRect.begin(), boundRect.end(), compareXCords);
-
-    unsigned int i=0;
-    while (i<boundRect.size()-1){
-        if (boundRect[i].tl().x <= boundRect[i+1].tl().x && 
-            boundRect[i].br().x >= boundRect[i+1].br().x
-        ){
-            int minX = min(boundRect[i].tl().x, boundRect[i+1].tl().x);
-            int minY = min(boundRect[i].tl().y, boundRect[i+1].tl().y);
-            int maxY = max(boundRect[i].br().y, boundRect[i+1].br().y);
-
-            int width = max(boundRect[i].width, boundRect[i+1].width);
-            int height = abs(minY - maxY);
-
-            boundRect[i+1] = Rect(minX, minY, width, height);
-            boundRect.erase(boundRect.begin() + i);
-            continue;
-        }
-        ++i;
-    }
+    processBounds(imgFiltered, boundRect);
 }
 
-void WordSegmentation::segment(Mat line, vector<Mat> &words){
+// words[0] is the overview image (empty if overview is false), followed by the word crops
+void WordSegmentation::segment(Mat line, vector<Mat> &words, bool overview){
     copyMakeBorder(line, line, 10, 10, 10, 10, BORDER_CONSTANT, 255);
 
-    Mat imgFiltered;
-    filter2D(line, imgFiltered, CV_8UC1, this->kernel);
-    threshold(imgFiltered, imgFiltered, 0, 255, THRESH_BINARY_INV | THRESH_OTSU);
-
     vector<Rect> boundRect;
-    processBounds(imgFiltered, boundRect);
+    locateWords(line, boundRect);
 
     Mat imageColor;
-    cvtColor(line, imageColor, COLOR_GRAY2BGR);
+    if (overview)
+        cvtColor(line, imageColor, COLOR_GRAY2BGR);
 
     for (unsigned int i=0; i<boundRect.size(); i++){
-        Mat cropped;
-        line(boundRect[i]).copyTo(cropped);
+        Mat cropped = line(boundRect[i]);
 
-        rectangle(imageColor, boundRect[i].tl(), boundRect[i].br(), cv::Scalar(0,0,255), 2, 8, 0);
-        putText(imageColor, to_string(i+1), boundRect[i].tl(), FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255,0,0), 2);
+        if (overview){
+            rectangle(imageColor, boundRect[i].tl(), boundRect[i].br(), cv::Scalar(0,0,255), 2, 8, 0);
+            putText(imageColor, to_string(i+1), boundRect[i].tl(), FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(255,0,0), 2);
+        }
         words.push_back(cropped);
     }
 
@@ -86,24 +57,217 @@ void WordSegmentation::segment(Mat line, vector<Mat> &words){
     rotate(words.rbegin(), words.rbegin()+1, words.rend());
 }
 
-void WordSegmentation::setKernel(int kernelSize, int sigma, int theta){
-    Mat kernel = Mat::zeros(Size(kernelSize, kernelSize), CV_32F);
-    float sigmaX = sigma;
-	float sigmaY = sigma * theta;
+// The kernel of setKernel, taken untruncated, is proportional to
+// (vX^2 d2/dx2 + (vX - vX^2)) G / Cx + (vY^2 d2/dy2 + (vY - vY^2)) G / Cy with G the gaussian with
+// variances vX = sigma and vY = sigma*theta, Cx = 2pi vX^5 vY and Cy = 2pi vY^5 vX. Normalised to
+// sum 1 its response is L + (vX^2/Cx Lxx + vY^2/Cy Lyy) / ((vX - vX^2)/Cx + (vY - vY^2)/Cy), with L the
+// image blurred by G. So each scale costs an incremental blur of the previous scale and a 3x3 filter.
+// The scale in the middle of the longest run of scales giving the same number of words (more than
+// one if possible) is picked.
+int WordSegmentation::locateWordsMultiScale(Mat padded, vector<Rect> &boundRect){
+    vector<vector<Rect>> found(this->scales.size());
+    Mat level, response, imgFiltered;
+    padded.convertTo(level, CV_32F);
+    double vX0 = 0, vY0 = 0;
 
-    for (int i=0; i<kernelSize; i++){
-        for (int j=0; j<kernelSize; j++){
-            float x = i - (kernelSize / 2);
-            float y = j - (kernelSize / 2);
+    for (unsigned int k=0; k<this->scales.size(); k++){
+        double vX = this->scales[k];
+        double vY = vX * this->scalesTheta;
+        // x runs over the rows, y over the columns
+        GaussianBlur(level, level, Size(0, 0), sqrt(vY - vY0), sqrt(vX - vX0), BORDER_REPLICATE);
+        vX0 = vX;
+        vY0 = vY;
+
+        double cX = 2 * CV_PI * pow(vX, 5) * vY;
+        double cY = 2 * CV_PI * pow(vY, 5) * vX;
+        double total = (vX - vX*vX) / cX + (vY - vY*vY) / cY;
+        float wX = (vX*vX / cX) / total;
+        float wY = (vY*vY / cY) / total;
+
+        Mat kernel = Mat::zeros(3, 3, CV_32F);
+        kernel.at<float>(0, 1) = kernel.at<float>(2, 1) = wX;
+        kernel.at<float>(1, 0) = kernel.at<float>(1, 2) = wY;
+        kernel.at<float>(1, 1) = 1 - 2*wX - 2*wY;
+        filter2D(level, response, CV_32F, kernel, Point(-1, -1), 0, BORDER_REPLICATE);
+        response.convertTo(imgFiltered, CV_8UC1);
+        threshold(imgFiltered, imgFiltered, 0, 255, THRESH_BINARY_INV | THRESH_OTSU);
+        processBounds(imgFiltered, found[k]);
+    }
+
+    int bestStart = 0, bestLength = 0;
+    bool bestSplit = false;
+    for (int start = 0, end; start < (int) found.size(); start = end){
+        for (end = start + 1; end < (int) found.size() && found[end].size() == found[start].size(); end++);
+        bool split = found[start].size() > 1;
+        if ((split && !bestSplit) || (split == bestSplit && end - start > bestLength)){
+            bestStart = start;
+            bestLength = end - start;
+            bestSplit = split;
+        }
+    }
+
+    int best = bestStart + (bestLength - 1) / 2;
+    boundRect = found[best];
+    return this->scales[best];
+}
 
-            float termExp = exp((-pow(x,2) / (2*sigmaX)) - (pow(y,2) / (2*sigmaY)));
+void WordSegmentation::segmentBoxes(Mat line, vector<Rect> &boxes, int *sigma){
+    boxes.clear();
+    if (this->kernelTermX.empty() && this->scales.empty()){
+        if (sigma) *sigma = 0;
+        return;
+    }
+
+    Mat padded;
+    copyMakeBorder(line, padded, 10, 10, 10, 10, BORDER_CONSTANT, 255);
+
+    vector<Rect> boundRect;
+    int used = this->kernelSigma;
+    if (this->scales.empty())
+        locateWords(padded, boundRect);
+    else
+        used = locateWordsMultiScale(padded, boundRect);
+    if (sigma) *sigma = used;
+
+    // the filter response can reach into the padding
+    Rect area(0, 0, line.cols, line.rows);
+    for (unsigned int i=0; i<boundRect.size(); i++){
+        Rect r = (boundRect[i] - Point(10, 10)) & area;
+        if (r.area() > 0) boxes.push_back(r);
+    }
+}
+
+// segments the lines of a range, each line is independent of the others
+class PageWordsBody : public ParallelLoopBody {
+    public:
+        PageWordsBody(WordSegmentation &word, Mat page, const vector<vector<Point>> &paths, vector<Mat> &lines, vector<Rect> &lineRects, vector<vector<Rect>> &boxes, vector<int> &sigmas)
+            : word(word), page(page), paths(paths), lines(lines), lineRects(lineRects), boxes(boxes), sigmas(sigmas) {}
+
+        void operator()(const Range &range) const {
+            for (int i = range.start; i < range.end; i++){
+                // the upper border from left to right, the lower border back from right to left
+                vector<Point> polygon;
+                if (i == 0){
+                    polygon.push_back(Point(0, 0));
+                    polygon.push_back(Point(page.cols-1, 0));
+                } else {
+                    polygon = paths[i-1];
+                    sort(polygon.begin(), polygon.end(), [](const Point &a, const Point &b){ return a.x < b.x; });
+                }
+                if (i == (int) paths.size()){
+                    polygon.push_back(Point(page.cols-1, page.rows-1));
+                    polygon.push_back(Point(0, page.rows-1));
+                } else {
+                    vector<Point> lower = paths[i];
+                    sort(lower.begin(), lower.end(), [](const Point &a, const Point &b){ return a.x > b.x; });
+                    polygon.insert(polygon.end(), lower.begin(), lower.end());
+                }
+
+                Rect roi = boundingRect(polygon) & Rect(0, 0, page.cols, page.rows);
+                lineRects[i] = roi;
+                if (roi.area() == 0) continue;
 
-            float termX = (pow(x,2) - pow(sigmaX,2)) / (2 * CV_PI * pow(sigmaX,5) * sigmaY);
-            float termY = (pow(y,2) - pow(sigmaY,2)) / (2 * CV_PI * pow(sigmaY,5) * sigmaX);
+                Mat mask = Mat::zeros(roi.size(), CV_8U);
+                vector<vector<Point>> polygons(1, polygon);
+                fillPoly(mask, polygons, Scalar(255), LINE_8, 0, -roi.tl());
+                lines[i] = Mat(roi.size(), CV_8U, Scalar(255));
+                page(roi).copyTo(lines[i], mask);
 
-            kernel.at<float>(i,j) = (termX + termY) * termExp;
+                word.segmentBoxes(lines[i], boxes[i], &sigmas[i]);
+                for (unsigned int j=0; j<boxes[i].size(); j++)
+                    boxes[i][j] += roi.tl();
+            }
         }
+
+    private:
+        WordSegmentation &word;
+        Mat page;
+        const vector<vector<Point>> &paths;
+        vector<Mat> &lines;
+        vector<Rect> &lineRects;
+        vector<vector<Rect>> &boxes;
+        vector<int> &sigmas;
+};
+
+void WordSegmentation::segmentPage(Mat page, const vector<vector<Point>> &paths, vector<Mat> &lines, vector<Rect> &lineRects, vector<vector<Rect>> &boxes, vector<int> &sigmas){
+    if (page.channels() == 3)
+        cvtColor(page, page, COLOR_BGR2GRAY);
+    else if (page.channels() == 4)
+        cvtColor(page, page, COLOR_BGRA2GRAY);
+
+    int n = (int) paths.size() + 1;
+    lines.assign(n, Mat());
+    lineRects.assign(n, Rect());
+    boxes.assign(n, vector<Rect>());
+    sigmas.assign(n, 0);
+    parallel_for_(Range(0, n), PageWordsBody(*this, page, paths, lines, lineRects, boxes, sigmas));
+}
+
+// The anisotropic kernel (termX(x) + termY(y)) * exp(-x^2/(2*sigmaX)) * exp(-y^2/(2*sigmaY))
+// is the sum of the separable terms (termX*gx) x gy and gx x (termY*gy), so it is applied as
+// two pairs of 1D passes. Built kernels are shared between instances and threads.
+struct SeparableKernel {
+    Mat termX, gaussY, gaussX, termY;
+};
+
+static SeparableKernel buildKernel(int kernelSize, int sigma, int theta){
+    SeparableKernel k;
+    k.termX.create(kernelSize, 1, CV_32F);
+    k.gaussX.create(kernelSize, 1, CV_32F);
+    k.termY.create(kernelSize, 1, CV_32F);
+    k.gaussY.create(kernelSize, 1, CV_32F);
+    double sigmaX = sigma;
+    double sigmaY = sigma * theta;
+
+    double sumTermX = 0, sumGaussX = 0, sumTermY = 0, sumGaussY = 0;
+    for (int i=0; i<kernelSize; i++){
+        double d = i - (kernelSize / 2);
+        double gx = exp(-d*d / (2*sigmaX));
+        double tx = (d*d - sigmaX*sigmaX) / (2 * CV_PI * pow(sigmaX,5) * sigmaY) * gx;
+        double gy = exp(-d*d / (2*sigmaY));
+        double ty = (d*d - sigmaY*sigmaY) / (2 * CV_PI * pow(sigmaY,5) * sigmaX) * gy;
+
+        k.gaussX.at<float>(i) = gx;
+        k.termX.at<float>(i) = tx;
+        k.gaussY.at<float>(i) = gy;
+        k.termY.at<float>(i) = ty;
+        sumGaussX += gx; sumTermX += tx;
+        sumGaussY += gy; sumTermY += ty;
+    }
+
+    // normalise the 2D kernel to sum 1 through the factors over the rows
+    double total = sumTermX * sumGaussY + sumGaussX * sumTermY;
+    k.termX /= total;
+    k.gaussX /= total;
+    return k;
+}
+
+void WordSegmentation::setKernel(int kernelSize, int sigma, int theta){
+    static std::map<std::tuple<int,int,int>, SeparableKernel> cache;
+    static std::mutex cacheMutex;
+
+    SeparableKernel k;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        std::tuple<int,int,int> key = std::make_tuple(kernelSize, sigma, theta);
+        std::map<std::tuple<int,int,int>, SeparableKernel>::iterator it = cache.find(key);
+        if (it == cache.end())
+            it = cache.insert(std::make_pair(key, buildKernel(kernelSize, sigma, theta))).first;
+        k = it->second;
     }
 
-    this->kernel = kernel / sum(kernel)[0];
+    this->kernelTermX = k.termX;
+    this->kernelGaussY = k.gaussY;
+    this->kernelGaussX = k.gaussX;
+    this->kernelTermY = k.termY;
+    this->kernelSigma = sigma;
+}
+
+void WordSegmentation::setScales(vector<int> sigmas, int theta){
+    // the response is undefined for sigma 1, where the kernel sums to zero
+    sigmas.erase(remove_if(sigmas.begin(), sigmas.end(), [](int s){ return s <= 1; }), sigmas.end());
+    sort(sigmas.begin(), sigmas.end());
+    sigmas.erase(unique(sigmas.begin(), sigmas.end()), sigmas.end());
+    this->scales = sigmas;
+    this->scalesTheta = max(theta, 1);
 }
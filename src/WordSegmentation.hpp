@@ -9,14 +9,32 @@ class WordSegmentation {
     public:
         WordSegmentation();
 
-        void segment(Mat line, vector<Mat> &words);
+        void segment(Mat line, vector<Mat> &words, bool overview = true);
+        // word boxes of a line, in the coordinates of the line. With scales set, sigma receives
+        // the scale which was picked for the line
+        void segmentBoxes(Mat line, vector<Rect> &boxes, int *sigma = nullptr);
+        // word boxes of all the lines of a page in parallel. The lines are the areas between the
+        // top of the page, the consecutive paths and the bottom of the page. lines receives each
+        // line (white outside of its area) and lineRects where it is located on the page, boxes
+        // receives the word boxes of each line in page coordinates and sigmas the scale of each line.
+        // Without setKernel/setScales only the lines are cut out
+        void segmentPage(Mat page, const vector<vector<Point>> &paths, vector<Mat> &lines, vector<Rect> &lineRects, vector<vector<Rect>> &boxes, vector<int> &sigmas);
         void setKernel(int kernelSize, int sigma, int theta);
+        // segmentBoxes/segmentPage evaluate each of these sigma values (bigger than 1) on a
+        // gaussian scale space of the line and pick the most stable one, instead of the kernel
+        void setScales(vector<int> sigmas, int theta);
 
     private:
         string srcBase; 
         string extension;
-        Mat kernel;
+        // the kernel is the sum of two separable terms, each a pair of 1D kernels over
+        // the rows (x) and the columns (y), see setKernel
+        Mat kernelTermX, kernelGaussY, kernelGaussX, kernelTermY;
+        int kernelSigma;
+        vector<int> scales;
+        int scalesTheta;
 
-        void printContours(Mat image, vector<vector<Point>> contours, vector<Vec4i> hierarchy, int idx);
         void processBounds(Mat &image, vector<Rect> &boundRect);
+        void locateWords(Mat padded, vector<Rect> &boundRect);
+        int locateWordsMultiScale(Mat padded, vector<Rect> &boundRect);
 };
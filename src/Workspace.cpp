@@ -0,0 +1,34 @@
+#include "Workspace.hpp"
+
+Workspace &Workspace::local() {
+    static thread_local Workspace workspace;
+    return workspace;
+}
+
+Mat Workspace::get(const string &name, int rows, int cols, int type) {
+    Mat &buffer = this->buffers[name];
+
+    // grow to the largest page seen so far, a view on an older buffer keeps that one alive
+    if (buffer.type() != type || buffer.rows < rows || buffer.cols < cols) {
+        bool sameType = !buffer.empty() && buffer.type() == type;
+        int newRows = sameType ? max(rows, buffer.rows) : rows;
+        int newCols = sameType ? max(cols, buffer.cols) : cols;
+
+        size_t kept = (size_t) newRows * newCols * CV_ELEM_SIZE(type);
+        for (auto &other : this->buffers) {
+            if (other.first != name)
+                kept += other.second.total() * other.second.elemSize();
+        }
+        if (kept > limit) {
+            // too large to keep, the caller owns the only reference
+            this->buffers.erase(name);
+            return Mat(rows, cols, type);
+        }
+        buffer.create(newRows, newCols, type);
+    }
+    return buffer(Rect(0, 0, cols, rows));
+}
+
+void Workspace::release() {
+    this->buffers.clear();
+}
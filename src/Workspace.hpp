@@ -0,0 +1,23 @@
+#pragma once
+#include <map>
+#include <string>
+#include <opencv2/core/core.hpp>
+
+using namespace cv;
+using namespace std;
+
+// Scratch images of the calling thread, kept between calls so that the next page
+// of a similar size reuses them instead of allocating again. get() returns a view
+// with undefined content, valid until the next get() of the same name on the same thread.
+// A thread keeps at most limit bytes, the images of larger pages are freed once their views are.
+class Workspace {
+    public:
+        static Workspace &local();
+        static const size_t limit = 64 << 20;
+
+        Mat get(const string &name, int rows, int cols, int type);
+        void release();
+
+    private:
+        map<string, Mat> buffers;
+};
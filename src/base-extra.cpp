@@ -3,19 +3,25 @@
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
+//wrap the R vector without copying it. It is kept alive by the image and marked as not mutable,
+//so R copies it instead of changing the pixels of the image
+static XPtrMat cvmat_raw(Rcpp::RawVector img, int width, int height, int type){
+  if((double) img.size() < (double) width * height * CV_MAT_CN(type))
+    Rcpp::stop("raw vector is smaller than width x height x channels");
+  MARK_NOT_MUTABLE(img);
+  cv::Mat output(height, width, type, RAW(img));
+  return cvmat_xptr(output, img);
+}
+
 // [[Rcpp::export]]
 XPtrMat cvmat_bgr(Rcpp::RawVector img, int width = 0, int height = 0){
-  std::vector<uchar> x = Rcpp::as<std::vector<uchar>>(img);
-  cv::Mat output(height, width, CV_8UC3, x.data());
-  return cvmat_xptr(output);
+  return cvmat_raw(img, width, height, CV_8UC3);
 }
 
 
 // [[Rcpp::export]]
 XPtrMat cvmat_bw(Rcpp::RawVector img, int width = 0, int height = 0){
-  std::vector<uchar> x = Rcpp::as<std::vector<uchar>>(img);
-  cv::Mat output(height, width, CV_8U, x.data());
-  return cvmat_xptr(output);
+  return cvmat_raw(img, width, height, CV_8U);
 }
 
 
@@ -24,7 +30,7 @@ XPtrMat cvmat_rect(XPtrMat ptr, int x, int y, int width = 0, int height = 0){
   cv::Mat img = get_mat(ptr);
   cv::Rect roi = cv::Rect(x, y, width, height);
   cv::Mat output = img(roi);
-  return cvmat_xptr(output);
+  return cvmat_xptr(output, ptr.prot());
 }
 
 
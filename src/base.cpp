@@ -11,21 +11,36 @@ void finalize_mat( cv::Mat * frame ){
   frame = NULL;
 }
 
-//assume ownership
-XPtrMat cvmat_xptr(cv::Mat *frame){
-  XPtrMat ptr(frame);
+//assume ownership, prot is kept alive as long as the image
+XPtrMat cvmat_xptr(cv::Mat *frame, SEXP prot){
+  XPtrMat ptr(frame, true, R_NilValue, prot);
   ptr.attr("class") = Rcpp::CharacterVector::create("opencv-image");
   return ptr;
 }
 
-//copy from stack to heap
+XPtrMat cvmat_xptr(cv::Mat *frame){
+  return cvmat_xptr(frame, R_NilValue);
+}
+
+//the header is put on the heap and shares the refcounted buffer of orig (e.g. a crop shares
+//the pixels of its page), only images on memory which opencv does not own are copied
 XPtrMat cvmat_xptr(cv::Mat orig){
-  cv::Mat * frame = new cv::Mat();
-  orig.copyTo(*frame);
-  return cvmat_xptr(frame);
+  return cvmat_xptr(orig, R_NilValue);
+}
+
+//as above, but images on memory which is kept alive by prot (an R vector) are shared as well
+XPtrMat cvmat_xptr(cv::Mat orig, SEXP prot){
+  if(orig.u != NULL || orig.data == NULL){
+    return cvmat_xptr(new cv::Mat(orig));
+  }
+  if(prot == R_NilValue){
+    return cvmat_xptr(new cv::Mat(orig.clone()));
+  }
+  return cvmat_xptr(new cv::Mat(orig), prot);
 }
 
 //opencv has internal refcount system
+//images share their pixels with the images they were derived from, so never write into the result
 cv::Mat get_mat(XPtrMat image){
   if(!image.inherits("opencv-image"))
     throw std::runtime_error("Image is not a opencv-image object");
@@ -108,13 +123,17 @@ cv::Mat get_mat(XPtrMat image){
 // 
 // [[Rcpp::export]]
 Rcpp::RawVector cvmat_bitmap(XPtrMat ptr){
-  cv::Mat output;
   cv::Mat input = get_mat(ptr);
-  cvtColor(input, output, COLOR_BGR2RGB);
-  size_t size = output.total();
-  size_t channels = output.channels();
-  Rcpp::RawVector res(size * channels);
-  std::memcpy(res.begin(), output.datastart, size * channels);
+  // colour images become RGB, dropping an alpha channel
+  size_t channels = input.channels() == 1 ? 1 : 3;
+  Rcpp::RawVector res(input.total() * channels);
+  //write straight into the R vector
+  cv::Mat output(input.rows, input.cols, channels == 1 ? CV_8UC1 : CV_8UC3, RAW(res));
+  if(channels == 1){
+    input.copyTo(output);
+  }else{
+    cvtColor(input, output, input.channels() == 4 ? COLOR_BGRA2RGB : COLOR_BGR2RGB, 3);
+  }
   res.attr("dim") = Rcpp::NumericVector::create(channels, output.cols, output.rows);
   return res;
 }
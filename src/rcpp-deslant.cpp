@@ -7,9 +7,31 @@
 
 
 // [[Rcpp::export]]
-XPtrMat textlinedetector_deslant(XPtrMat ptr, const int bgcolor=255, const float lower_bound=-1.0, const float upper_bound=1.0){
+XPtrMat textlinedetector_deslant(XPtrMat ptr, const int bgcolor=255, const float lower_bound=-1.0, const float upper_bound=1.0, const float precision=0.0){
   cv::Mat image = get_mat(ptr);
   cv::Mat imageDeslanted;
-  imageDeslanted = htr::deslantImg(image, bgcolor, lower_bound, upper_bound);
-  return cvmat_xptr(imageDeslanted);
-}
\ No newline at end of file
+  float alpha;
+  imageDeslanted = htr::deslantImg(image, bgcolor, lower_bound, upper_bound, precision, &alpha);
+  XPtrMat out = cvmat_xptr(imageDeslanted);
+  out.attr("alpha") = alpha;
+  return out;
+}
+
+// [[Rcpp::export]]
+Rcpp::List textlinedetector_deslant_list(Rcpp::List ptrs, const int bgcolor=255, const float lower_bound=-1.0, const float upper_bound=1.0, const float precision=0.0){
+  std::vector<cv::Mat> images;
+  for (int i = 0; i < ptrs.size(); i++){
+    XPtrMat ptr = Rcpp::as<XPtrMat>(ptrs[i]);
+    images.push_back(get_mat(ptr));
+  }
+  std::vector<float> alphas;
+  htr::deslantImgs(images, alphas, true, bgcolor, lower_bound, upper_bound, precision);
+  
+  Rcpp::List out(images.size());
+  for (unsigned int i = 0; i < images.size(); i++){
+    XPtrMat deslanted = cvmat_xptr(images[i]);
+    deslanted.attr("alpha") = alphas[i];
+    out[i] = deslanted;
+  }
+  return out;
+}
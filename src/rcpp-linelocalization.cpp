@@ -2,6 +2,7 @@
 // For opencv R package
 #include "opencv_types.h"
 #include "util.hpp"
+#include "Workspace.hpp"
 // For line localization
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
@@ -10,9 +11,8 @@ using namespace std;
 using namespace cv;
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-inline Mat distance_transform (Mat input) {
+inline void distance_transform (Mat input, Mat dmat) {
 
-	Mat dmat = input.clone();
 	for (int i = 0; i < input.cols; i++) {
 		Mat column = input(Rect(i, 0, 1, input.rows));
 		Mat dcol;
@@ -23,8 +23,6 @@ inline Mat distance_transform (Mat input) {
 #endif		
 		dcol.copyTo(dmat.col(i));
 	}
-
-	return dmat;
 }
 template<typename Node>
 inline Mat segment_line (Mat& input, vector<Node> path){
@@ -355,11 +353,14 @@ inline void astar_search (const Graph& graph, typename Graph::Node start, typena
 
 
 // [[Rcpp::export]]
-Rcpp::List textlinedetector_astarpath(XPtrMat ptr, bool morph = true, int step = 2, int mfactor = 5, bool trace = true){
+Rcpp::List textlinedetector_astarpath(XPtrMat ptr, bool morph = true, int step = 2, int mfactor = 5, bool trace = true, bool overview = true){
   cv::Mat img = get_mat(ptr);
-  cv::Mat imbw = img.clone();
+  // the scratch images are reused by the next page processed on this thread
+  Workspace &workspace = Workspace::local();
+  cv::Mat imbw = img;
   if(morph){
     Mat element = getStructuringElement( MORPH_RECT, Size(5, 5), Point(2, 2));
+    imbw = workspace.get("astar.bw", img.rows, img.cols, img.type());
     morphologyEx(img, imbw, 2, element );
   }
   if(trace) Rcpp::Rcout << "- Detecting lines location..";
@@ -367,11 +368,14 @@ Rcpp::List textlinedetector_astarpath(XPtrMat ptr, bool morph = true, int step =
   if(trace) Rcpp::Rcout << " ==> " << lines.size() + 1 << " areas found." << endl;
   if(trace) Rcpp::Rcout << "- A* path planning algorithm.." << endl;
   Map map;
-  map.grid = imbw / 255;
-  map.dmat = distance_transform(map.grid);
+  map.grid = workspace.get("astar.grid", imbw.rows, imbw.cols, imbw.type());
+  imbw.convertTo(map.grid, -1, 1.0/255);
+  map.dmat = workspace.get("astar.dmat", imbw.rows, imbw.cols, imbw.type());
+  distance_transform(map.grid, map.dmat);
   typedef Map::Node Node;
 	vector<vector<Node>> paths;
-	Mat image_path = map.grid.clone();
+	Mat image_path;
+	if (overview) image_path = map.grid.clone();
   Rcpp::List segmented_boxes(lines.size() + 1);
   int previous_y = 0;
   int i = 1;
@@ -402,17 +406,17 @@ Rcpp::List textlinedetector_astarpath(XPtrMat ptr, bool morph = true, int step =
     int height = current_y - previous_y;
     //Rcpp::Rcout << current_y << " " << previous_y << " " << width << " " << height << "::" << img.rows << "x" << img.cols << "\n";
     cv::Mat cropped = img(cv::Rect(0, previous_y, width, height));    
-    segmented_boxes[i-1] = cvmat_xptr(cropped);
+    segmented_boxes[i-1] = cvmat_xptr(cropped, ptr.prot());
     previous_y = current_y;
 
 		unordered_map<Node, Node> parents;
     astar_search(map, start, goal, parents, "NULL", step, mfactor);
     vector<Node> path = reconstruct_path(start, goal, parents);
-    draw_path(image_path, path);
+    if (overview) draw_path(image_path, path);
     paths.push_back(path);
   }
   cv::Mat cropped = img(cv::Rect(0, previous_y, img.cols, img.rows - previous_y));
-  segmented_boxes[i] = cvmat_xptr(cropped);
+  segmented_boxes[i] = cvmat_xptr(cropped, ptr.prot());
 
   Rcpp::List pathlines(paths.size());
   for (unsigned int i=0; i<paths.size(); i++) {
@@ -431,8 +435,10 @@ Rcpp::List textlinedetector_astarpath(XPtrMat ptr, bool morph = true, int step =
   }
   
 
+  Rcpp::RObject drawing = R_NilValue;
+  if (overview) drawing = cvmat_xptr(image_path*255);
   return Rcpp::List::create(Rcpp::Named("n") = paths.size(),
-                            Rcpp::Named("overview") = cvmat_xptr(image_path*255), 
+                            Rcpp::Named("overview") = drawing, 
                             Rcpp::Named("paths") = pathlines,
                             Rcpp::Named("lines") = Rcpp::DataFrame::create(Rcpp::Named("x_from") = from_x, Rcpp::Named("x_to") = to_x,
                                                                            Rcpp::Named("y_from") = from_y, Rcpp::Named("y_to") = to_y),
@@ -7,16 +7,51 @@
 #include "Scanner.hpp"
 #include "LineSegmentation.hpp"
 #include "WordSegmentation.hpp"
+#include "Pipeline.hpp"
+#include "Batch.hpp"
 #include <string>
 
+// the crop followed by the resampling of the cropped image to size
+Rcpp::NumericMatrix crop_transform(Scanner &scanner, cv::Size size){
+  cv::Mat scaling = cv::Mat::eye(3, 3, CV_64F);
+  scaling.at<double>(0, 0) = (double) size.width / max(scanner.cropSize.width, 1);
+  scaling.at<double>(1, 1) = (double) size.height / max(scanner.cropSize.height, 1);
+  cv::Mat composed = scaling * scanner.transform;
+  Rcpp::NumericMatrix transform(3, 3);
+  for (int i=0; i<3; i++) {
+    for (int j=0; j<3; j++) {
+      transform(i, j) = composed.at<double>(i, j);
+    }
+  }
+  return transform;
+}
+
 // [[Rcpp::export]]
-XPtrMat textlinedetector_crop(XPtrMat ptr){
+XPtrMat textlinedetector_crop(XPtrMat ptr, int width = 0, int height = 0, bool precheck = false){
   cv::Mat image = get_mat(ptr);
   
-  Scanner *scanner = new Scanner();
+  Scanner scanner;
+  scanner.precheck = precheck;
   cv::Mat imageCropped;
-  scanner->process(image, imageCropped);
-  return cvmat_xptr(imageCropped);
+  scanner.locate(image);
+  scanner.warp(image, imageCropped, width, height);
+  XPtrMat out = cvmat_xptr(imageCropped, ptr.prot());
+  out.attr("cropped") = scanner.cropped;
+  out.attr("transform") = crop_transform(scanner, imageCropped.size());
+  return out;
+}
+
+// [[Rcpp::export]]
+Rcpp::List textlinedetector_crop_transform(XPtrMat ptr, bool precheck = false){
+  cv::Mat image = get_mat(ptr);
+  
+  Scanner scanner;
+  scanner.precheck = precheck;
+  scanner.locate(image);
+  return Rcpp::List::create(Rcpp::Named("cropped") = scanner.cropped,
+                            Rcpp::Named("transform") = crop_transform(scanner, scanner.cropSize),
+                            Rcpp::Named("width") = scanner.cropSize.width,
+                            Rcpp::Named("height") = scanner.cropSize.height);
 }
 
 // [[Rcpp::export]]
@@ -30,24 +65,25 @@ XPtrMat textlinedetector_resize(XPtrMat ptr, int width = 1280){
 }
 
 // [[Rcpp::export]]
-XPtrMat textlinedetector_binarization(XPtrMat ptr, bool light = true, int type = 3){
+XPtrMat textlinedetector_binarization(XPtrMat ptr, bool light = true, int type = 3, double lightScale = 1.0, int tileRows = 0){
   cv::Mat imageCropped = get_mat(ptr);
   
-  Binarization *threshold = new Binarization();
+  Binarization threshold;
   cv::Mat imageBinary;
-  threshold->binarize(imageCropped, imageBinary, light, type);
-  return cvmat_xptr(imageBinary);
+  threshold.tileRows = tileRows;
+  threshold.binarize(imageCropped, imageBinary, light, type, lightScale);
+  return cvmat_xptr(imageBinary, ptr.prot());
 }
 
 
 // [[Rcpp::export]]
-Rcpp::List textlinedetector_linesegmentation(XPtrMat ptr, int chunksNumber = 8, int chunksProcess = 4, int kernelSize = 11, int sigma = 11, int theta = 7){
+Rcpp::List textlinedetector_linesegmentation(XPtrMat ptr, int chunksNumber = 8, int chunksProcess = 4, int kernelSize = 11, int sigma = 11, int theta = 7, bool overview = true, int deslant = 1){
   cv::Mat imageBinary = get_mat(ptr);
   
-  LineSegmentation *line = new LineSegmentation();
+  LineSegmentation line;
   std::vector<cv::Mat> lines;
-  cv::Mat imageLines = imageBinary.clone();
-  line->segment(imageLines, lines, chunksNumber, chunksProcess);
+  cv::Mat imageLines = overview ? imageBinary.clone() : imageBinary;
+  line.segment(imageLines, lines, chunksNumber, chunksProcess, overview, deslant);
 
   Rcpp::List textlines(lines.size());
   for (unsigned int i=0; i<lines.size(); i++) {
@@ -55,12 +91,12 @@ Rcpp::List textlinedetector_linesegmentation(XPtrMat ptr, int chunksNumber = 8,
   }
 
   // Get region x/y locations
-  unsigned int regions_nr = line->lineRegions.size();
-  Rcpp::List coords(regions_nr-1);
+  unsigned int regions_nr = line.lineRegions.size();
+  Rcpp::List coords(regions_nr > 0 ? regions_nr-1 : 0);
   for (unsigned int i=1; i<regions_nr; i++) {
     std::vector<int> top_x;
     std::vector<int> top_y;
-    Region * region = line->lineRegions[i];
+    Region * region = line.lineRegions[i];
     Line *top    = (*region).top;
     vector<Point> top_pts = (*top).points;
     for (auto point : top_pts) {
@@ -70,29 +106,220 @@ Rcpp::List textlinedetector_linesegmentation(XPtrMat ptr, int chunksNumber = 8,
     coords[i-1] = Rcpp::DataFrame::create(Rcpp::Named("x") = top_y,
                                           Rcpp::Named("y") = top_x);
   }
+  Rcpp::RObject drawing = R_NilValue;
+  if (overview) drawing = cvmat_xptr(imageLines);
   return Rcpp::List::create(Rcpp::Named("n") = lines.size(),
-                            Rcpp::Named("overview") = cvmat_xptr(imageLines),
+                            Rcpp::Named("overview") = drawing,
                             Rcpp::Named("textlines") = textlines,
-                            Rcpp::Named("paths") = coords);
+                            Rcpp::Named("paths") = coords,
+                            Rcpp::Named("alpha") = line.alphas);
 }
 
 // [[Rcpp::export]]
-Rcpp::List textlinedetector_wordsegmentation(XPtrMat ptr, int kernelSize = 11, int sigma = 11, int theta = 7){
+Rcpp::List textlinedetector_wordsegmentation(XPtrMat ptr, int kernelSize = 11, int sigma = 11, int theta = 7, bool overview = true){
   cv::Mat textlineimg = get_mat(ptr);
   
-  WordSegmentation *word = new WordSegmentation();
+  WordSegmentation word;
   cv::Mat summary;
-  word->setKernel(kernelSize, sigma, theta);
+  word.setKernel(kernelSize, sigma, theta);
   
   std::vector<cv::Mat> words;
-  word->segment(textlineimg, words);
+  word.segment(textlineimg, words, overview);
     
   Rcpp::List tokens(words.size()-1);
   for (unsigned int i=1; i<words.size(); i++) {
     tokens[i-1] = cvmat_xptr(words[i]);
   }
   
+  Rcpp::RObject drawing = R_NilValue;
+  if (overview) drawing = cvmat_xptr(words[0]);
   return Rcpp::List::create(Rcpp::Named("n") = words.size() - 1,
-                            Rcpp::Named("overview") = cvmat_xptr(words[0]),
+                            Rcpp::Named("overview") = drawing,
                             Rcpp::Named("words") = tokens);
-}
\ No newline at end of file
+}
+// one row per box: the line, the number of the box in the line and its location
+Rcpp::DataFrame boxes_frame(const std::vector<std::vector<cv::Rect>> &boxes){
+  std::vector<int> line_id, word_id, x, y, width, height;
+  for (unsigned int i = 0; i < boxes.size(); i++){
+    for (unsigned int j = 0; j < boxes[i].size(); j++){
+      line_id.push_back(i + 1);
+      word_id.push_back(j + 1);
+      x.push_back(boxes[i][j].x);
+      y.push_back(boxes[i][j].y);
+      width.push_back(boxes[i][j].width);
+      height.push_back(boxes[i][j].height);
+    }
+  }
+  return Rcpp::DataFrame::create(Rcpp::Named("line") = line_id,
+                                 Rcpp::Named("word") = word_id,
+                                 Rcpp::Named("x") = x,
+                                 Rcpp::Named("y") = y,
+                                 Rcpp::Named("width") = width,
+                                 Rcpp::Named("height") = height);
+}
+
+// [[Rcpp::export]]
+Rcpp::List textlinedetector_wordsegmentation_page(XPtrMat ptr, Rcpp::List paths, std::vector<int> sigma, int kernelSize = 11, int theta = 7, bool crops = false){
+  cv::Mat page = get_mat(ptr);
+  std::vector<std::vector<cv::Point>> linepaths;
+  for (int i = 0; i < paths.size(); i++){
+    linepaths.push_back(as_points(Rcpp::as<Rcpp::List>(paths[i])));
+  }
+  
+  WordSegmentation word;
+  if (sigma.size() == 1) {
+    word.setKernel(kernelSize, sigma[0], theta);
+  } else {
+    word.setScales(sigma, theta);
+  }
+  std::vector<cv::Mat> lines;
+  std::vector<cv::Rect> lineRects;
+  std::vector<std::vector<cv::Rect>> boxes;
+  std::vector<int> sigmas;
+  word.segmentPage(page, linepaths, lines, lineRects, boxes, sigmas);
+  
+  Rcpp::RObject words = R_NilValue;
+  if (crops) {
+    std::vector<cv::Mat> crops_mat;
+    for (unsigned int i = 0; i < boxes.size(); i++){
+      for (auto box : boxes[i]){
+        crops_mat.push_back(lines[i](box - lineRects[i].tl()));
+      }
+    }
+    Rcpp::List tokens(crops_mat.size());
+    for (unsigned int i = 0; i < crops_mat.size(); i++) {
+      tokens[i] = cvmat_xptr(crops_mat[i]);
+    }
+    words = tokens;
+  }
+  Rcpp::DataFrame table = boxes_frame(boxes);
+  return Rcpp::List::create(Rcpp::Named("n") = table.nrows(),
+                            Rcpp::Named("boxes") = table,
+                            Rcpp::Named("words") = words,
+                            Rcpp::Named("sigma") = sigmas);
+}
+
+// prot keeps the memory of the input image alive in case the page is the input image
+Rcpp::List page_result(PageResult &result, SEXP prot){
+  Rcpp::NumericMatrix transform(3, 3);
+  for (int i=0; i<3; i++) {
+    for (int j=0; j<3; j++) {
+      transform(i, j) = result.transform.at<double>(i, j);
+    }
+  }
+  Rcpp::List paths(result.paths.size());
+  for (unsigned int i = 0; i < result.paths.size(); i++){
+    std::vector<int> x, y;
+    for (auto point : result.paths[i]){
+      x.push_back(point.x);
+      y.push_back(point.y);
+    }
+    paths[i] = Rcpp::DataFrame::create(Rcpp::Named("x") = x,
+                                       Rcpp::Named("y") = y);
+  }
+  std::vector<int> line_id, x, y, width, height;
+  for (unsigned int i = 0; i < result.lineRects.size(); i++){
+    line_id.push_back(i + 1);
+    x.push_back(result.lineRects[i].x);
+    y.push_back(result.lineRects[i].y);
+    width.push_back(result.lineRects[i].width);
+    height.push_back(result.lineRects[i].height);
+  }
+  Rcpp::DataFrame lines = Rcpp::DataFrame::create(Rcpp::Named("line") = line_id,
+                                                  Rcpp::Named("x") = x,
+                                                  Rcpp::Named("y") = y,
+                                                  Rcpp::Named("width") = width,
+                                                  Rcpp::Named("height") = height);
+  
+  Rcpp::RObject page = R_NilValue, binary = R_NilValue, textlines = R_NilValue, tokens = R_NilValue;
+  if (!result.page.empty()){
+    page = cvmat_xptr(result.page, prot);
+    binary = cvmat_xptr(result.binary, prot);
+    Rcpp::List images(result.lines.size());
+    std::vector<cv::Mat> crops;
+    for (unsigned int i = 0; i < result.lines.size(); i++){
+      images[i] = cvmat_xptr(result.lines[i]);
+      crops.insert(crops.end(), result.wordImages[i].begin(), result.wordImages[i].end());
+    }
+    textlines = images;
+    Rcpp::List crops_list(crops.size());
+    for (unsigned int i = 0; i < crops.size(); i++){
+      crops_list[i] = cvmat_xptr(crops[i]);
+    }
+    tokens = crops_list;
+  }
+  return Rcpp::List::create(Rcpp::Named("cropped") = result.cropped,
+                            Rcpp::Named("transform") = transform,
+                            Rcpp::Named("width") = result.size.width,
+                            Rcpp::Named("height") = result.size.height,
+                            Rcpp::Named("paths") = paths,
+                            Rcpp::Named("lines") = lines,
+                            Rcpp::Named("words") = boxes_frame(result.words),
+                            Rcpp::Named("sigma") = result.sigmas,
+                            Rcpp::Named("alpha") = result.alphas,
+                            Rcpp::Named("page") = page,
+                            Rcpp::Named("binary") = binary,
+                            Rcpp::Named("textlines") = textlines,
+                            Rcpp::Named("wordimages") = tokens);
+}
+
+// the stage options, as made by pipeline_options in R
+Pipeline pipeline_options(Rcpp::List options){
+  Pipeline pipeline;
+  pipeline.crop = Rcpp::as<bool>(options["crop"]);
+  pipeline.precheck = Rcpp::as<bool>(options["precheck"]);
+  pipeline.width = Rcpp::as<int>(options["width"]);
+  pipeline.light = Rcpp::as<bool>(options["light"]);
+  pipeline.option = Rcpp::as<int>(options["type"]);
+  pipeline.lightScale = Rcpp::as<double>(options["light_scale"]);
+  pipeline.tileRows = Rcpp::as<int>(options["tile_rows"]);
+  pipeline.words = Rcpp::as<bool>(options["words"]);
+  pipeline.kernelSize = Rcpp::as<int>(options["kernelSize"]);
+  pipeline.sigmas = Rcpp::as<std::vector<int>>(options["sigma"]);
+  pipeline.theta = Rcpp::as<int>(options["theta"]);
+  pipeline.deslant = Rcpp::as<int>(options["deslant"]);
+  pipeline.keep = Rcpp::as<bool>(options["keep"]);
+  return pipeline;
+}
+
+// [[Rcpp::export]]
+Rcpp::List textlinedetector_pipeline(XPtrMat ptr, Rcpp::List options){
+  cv::Mat image = get_mat(ptr);
+  
+  Pipeline pipeline = pipeline_options(options);
+  PageResult result;
+  pipeline.process(image, result);
+  return page_result(result, ptr.prot());
+}
+
+// [[Rcpp::export]]
+Rcpp::List textlinedetector_pipeline_batch(Rcpp::List pages, Rcpp::List options, int threads = 0){
+  // the R objects are only touched here, the threads get the images or the file names
+  std::vector<cv::Mat> images(pages.size());
+  std::vector<std::string> paths(pages.size());
+  std::vector<SEXP> prots(pages.size(), R_NilValue);
+  for (int i = 0; i < pages.size(); i++){
+    if (Rf_isString(pages[i])) {
+      paths[i] = Rcpp::as<std::string>(pages[i]);
+    } else {
+      XPtrMat ptr = Rcpp::as<XPtrMat>(pages[i]);
+      images[i] = get_mat(ptr);
+      prots[i] = ptr.prot();
+    }
+  }
+  
+  Batch batch(pipeline_options(options), threads);
+  std::vector<PageResult> results;
+  std::vector<std::string> errors;
+  batch.process(images, paths, results, errors);
+  
+  Rcpp::List out(results.size());
+  for (unsigned int i = 0; i < results.size(); i++){
+    if (errors[i].empty()) {
+      out[i] = page_result(results[i], prots[i]);
+    } else {
+      out[i] = Rcpp::String(errors[i]);
+    }
+  }
+  return out;
+}
@@ -5,3 +5,5 @@ void detectAndDraw( cv::Mat img, cv::CascadeClassifier& cascade,
 cv::Mat get_mat(XPtrMat image);
 XPtrMat cvmat_xptr(cv::Mat *frame);
 XPtrMat cvmat_xptr(cv::Mat orig);
+XPtrMat cvmat_xptr(cv::Mat orig, SEXP prot);
+std::vector<cv::Point> as_points(Rcpp::List pts);